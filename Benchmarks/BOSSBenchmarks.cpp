@@ -1,8 +1,17 @@
+#include "../Source/Algorithm.hpp"
 #include "../Source/BOSS.hpp"
+#include "../Source/Engine.hpp"
+#include "../Source/ExpressionUtilities.hpp"
 #include "ITTNotifySupport.hpp"
+#include <array>
 #include <benchmark/benchmark.h>
 #include <iostream>
+#include <memory_resource>
+#include <numeric>
+#include <optional>
+#include <thread>
 using namespace std;
+using boss::utilities::operator""_;
 
 static auto const vtune = VTuneAPIInterface{"BOSS"};
 static void DummyBenchmark(benchmark::State& state) {
@@ -18,4 +27,548 @@ static void DummyBenchmark(benchmark::State& state) {
 }
 BENCHMARK(DummyBenchmark)->Range(0, 1024); // NOLINT
 
+// the TPC-H plans from Tests/BOSSTests.cpp (on an empty table)
+static boss::ComplexExpression tpchQ1() {
+  return "Order"_(
+      "Group"_(
+          "Project"_(
+              "Project"_(
+                  "Project"_(
+                      "Select"_("Project"_("Table"_(),
+                                           "As"_("L_QUANTITY"_, "L_QUANTITY"_, "L_DISCOUNT"_,
+                                                 "L_DISCOUNT"_, "L_SHIPDATE"_, "L_SHIPDATE"_,
+                                                 "L_EXTENDEDPRICE"_, "L_EXTENDEDPRICE"_,
+                                                 "L_RETURNFLAG"_, "L_RETURNFLAG"_, "L_LINESTATUS"_,
+                                                 "L_LINESTATUS"_, "L_TAX"_, "L_TAX"_)),
+                                "Where"_("Greater"_("DateObject"_("1998-08-31"), "L_SHIPDATE"_))),
+                      "As"_("L_RETURNFLAG"_, "L_RETURNFLAG"_, "L_LINESTATUS"_, "L_LINESTATUS"_,
+                            "L_QUANTITY"_, "L_QUANTITY"_, "L_EXTENDEDPRICE"_, "L_EXTENDEDPRICE"_,
+                            "L_DISCOUNT"_, "L_DISCOUNT"_, "calc1"_, "Minus"_(1.0, "L_DISCOUNT"_),
+                            "calc2"_, "Plus"_("L_TAX"_, 1.0))),
+                  "As"_("L_RETURNFLAG"_, "L_RETURNFLAG"_, "L_LINESTATUS"_, "L_LINESTATUS"_,
+                        "L_QUANTITY"_, "L_QUANTITY"_, "L_EXTENDEDPRICE"_, "L_EXTENDEDPRICE"_,
+                        "L_DISCOUNT"_, "L_DISCOUNT"_, "disc_price"_,
+                        "Times"_("L_EXTENDEDPRICE"_, "calc1"_), "calc2"_, "calc2"_)),
+              "As"_("L_RETURNFLAG"_, "L_RETURNFLAG"_, "L_LINESTATUS"_, "L_LINESTATUS"_,
+                    "L_QUANTITY"_, "L_QUANTITY"_, "L_EXTENDEDPRICE"_, "L_EXTENDEDPRICE"_,
+                    "L_DISCOUNT"_, "L_DISCOUNT"_, "disc_price"_, "disc_price"_, "calc"_,
+                    "Times"_("disc_price"_, "calc2"_))),
+          "By"_("L_RETURNFLAG"_, "L_LINESTATUS"_),
+          "As"_("SUM_QTY"_, "Sum"_("L_QUANTITY"_), "SUM_BASE_PRICE"_, "Sum"_("L_EXTENDEDPRICE"_),
+                "SUM_DISC_PRICE"_, "Sum"_("disc_price"_), "SUM_CHARGES"_, "Sum"_("calc"_),
+                "AVG_QTY"_, "Avg"_("L_QUANTITY"_), "AVG_PRICE"_, "Avg"_("L_EXTENDEDPRICE"_),
+                "AVG_DISC"_, "Avg"_("l_discount"_), "COUNT_ORDER"_, "Count"_("*"_))),
+      "By"_("L_RETURNFLAG"_, "L_LINESTATUS"_));
+}
+
+static boss::ComplexExpression tpchQ3() {
+  return "Top"_(
+      "Group"_(
+          "Project"_(
+              "Join"_(
+                  "Project"_(
+                      "Join"_(
+                          "Project"_(
+                              "Select"_("Project"_("Table"_(), "As"_("C_CUSTKEY"_, "C_CUSTKEY"_,
+                                                                    "C_MKTSEGMENT"_,
+                                                                    "C_MKTSEGMENT"_)),
+                                        "Where"_("StringContainsQ"_("C_MKTSEGMENT"_, "BUILDING"))),
+                              "As"_("C_CUSTKEY"_, "C_CUSTKEY"_)),
+                          "Select"_(
+                              "Project"_("Table"_(),
+                                         "As"_("O_ORDERKEY"_, "O_ORDERKEY"_, "O_ORDERDATE"_,
+                                               "O_ORDERDATE"_, "O_CUSTKEY"_, "O_CUSTKEY"_,
+                                               "O_SHIPPRIORITY"_, "O_SHIPPRIORITY"_)),
+                              "Where"_("Greater"_("DateObject"_("1995-03-15"), "O_ORDERDATE"_))),
+                          "Where"_("Equal"_("C_CUSTKEY"_, "O_CUSTKEY"_))),
+                      "As"_("O_ORDERKEY"_, "O_ORDERKEY"_, "O_ORDERDATE"_, "O_ORDERDATE"_,
+                            "O_CUSTKEY"_, "O_CUSTKEY"_, "O_SHIPPRIORITY"_, "O_SHIPPRIORITY"_)),
+                  "Project"_(
+                      "Select"_("Project"_("Table"_(),
+                                           "As"_("L_ORDERKEY"_, "L_ORDERKEY"_, "L_DISCOUNT"_,
+                                                 "L_DISCOUNT"_, "L_SHIPDATE"_, "L_SHIPDATE"_,
+                                                 "L_EXTENDEDPRICE"_, "L_EXTENDEDPRICE"_)),
+                                "Where"_("Greater"_("L_SHIPDATE"_, "DateObject"_("1993-03-15")))),
+                      "As"_("L_ORDERKEY"_, "L_ORDERKEY"_, "L_DISCOUNT"_, "L_DISCOUNT"_,
+                            "L_EXTENDEDPRICE"_, "L_EXTENDEDPRICE"_)),
+                  "Where"_("Equal"_("O_ORDERKEY"_, "L_ORDERKEY"_))),
+              "As"_("Expr1009"_, "Times"_("L_EXTENDEDPRICE"_, "Minus"_(1.0, "L_DISCOUNT"_)),
+                    "L_EXTENDEDPRICE"_, "L_EXTENDEDPRICE"_, "L_ORDERKEY"_, "L_ORDERKEY"_,
+                    "O_ORDERDATE"_, "O_ORDERDATE"_, "O_SHIPPRIORITY"_, "O_SHIPPRIORITY"_)),
+          "By"_("L_ORDERKEY"_, "O_ORDERDATE"_, "O_SHIPPRIORITY"_),
+          "As"_("revenue"_, "Sum"_("Expr1009"_))),
+      "By"_("revenue"_, "desc"_, "O_ORDERDATE"_), 10); // NOLINT
+}
+
+template <typename PlanBuilder>
+static void BuildAndDestroyPlan(benchmark::State& state, PlanBuilder buildPlan, bool useArena) {
+  for(auto _ : state) { // NOLINT
+    if(useArena) {
+      auto arena = std::pmr::monotonic_buffer_resource();
+      auto const scope = boss::expressions::ScopedExpressionMemoryResource(&arena);
+      auto plan = buildPlan();
+      benchmark::DoNotOptimize(plan);
+    } else {
+      auto plan = buildPlan();
+      benchmark::DoNotOptimize(plan);
+    }
+  }
+}
+BENCHMARK_CAPTURE(BuildAndDestroyPlan, Q1, tpchQ1, false);      // NOLINT
+BENCHMARK_CAPTURE(BuildAndDestroyPlan, Q1_Arena, tpchQ1, true); // NOLINT
+BENCHMARK_CAPTURE(BuildAndDestroyPlan, Q3, tpchQ3, false);      // NOLINT
+BENCHMARK_CAPTURE(BuildAndDestroyPlan, Q3_Arena, tpchQ3, true); // NOLINT
+
+// a table with four columns of state.range(0) rows each
+static boss::ComplexExpression table(size_t rows) {
+  auto columns = boss::ExpressionArguments();
+  for(auto const* name : {"a", "b", "c", "d"}) {
+    auto values = vector<int64_t>(rows);
+    std::iota(values.begin(), values.end(), 0);
+    auto spans = boss::expressions::ExpressionSpanArguments();
+    spans.emplace_back(boss::expressions::Span<int64_t>(std::move(values)));
+    columns.emplace_back("Column"_(boss::Symbol(name),
+                                   boss::ComplexExpression("List"_, {}, {}, std::move(spans))));
+  }
+  return boss::ComplexExpression("Table"_, std::move(columns));
+}
+
+static void CloneTable(benchmark::State& state, bool shared) {
+  auto original = table(state.range(0));
+  if(shared) {
+    original = std::move(original).share();
+  }
+  for(auto _ : state) { // NOLINT
+    auto copy = original.clone(boss::expressions::CloneReason::FOR_TESTING);
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK_CAPTURE(CloneTable, Deep, false)->Range(1, 1U << 20U);  // NOLINT
+BENCHMARK_CAPTURE(CloneTable, Shared, true)->Range(1, 1U << 20U); // NOLINT
+
+static void CompareTables(benchmark::State& state) {
+  auto const left = table(state.range(0));
+  auto const right = table(state.range(0));
+  for(auto _ : state) { // NOLINT
+    benchmark::DoNotOptimize(left == right);
+  }
+}
+BENCHMARK(CompareTables)->Range(1, 1U << 20U); // NOLINT
+
+// the revenue of TPC-H Q6: sum(l_extendedprice * l_discount), on decimal and on double columns
+static void Revenue(benchmark::State& state, bool decimal) {
+  auto prices = vector<boss::Decimal>(state.range(0));
+  auto discounts = vector<boss::Decimal>(state.range(0));
+  for(auto i = 0U; i < prices.size(); i++) {
+    prices[i] = boss::Decimal::fromUnscaledValue(9000000 + i % 100000); // NOLINT
+    discounts[i] = boss::Decimal::fromUnscaledValue(i % 11 * 100);      // NOLINT
+  }
+  auto const priceSpan = boss::Span<boss::Decimal const>(prices);
+  auto const discountSpan = boss::Span<boss::Decimal const>(discounts);
+  auto doublePrices = vector<double>(prices.size());
+  auto doubleDiscounts = vector<double>(prices.size());
+  for(auto i = 0U; i < prices.size(); i++) {
+    doublePrices[i] = prices[i].toDouble();
+    doubleDiscounts[i] = discounts[i].toDouble();
+  }
+  for(auto _ : state) { // NOLINT
+    if(decimal) {
+      auto products = boss::Span<boss::Decimal>(vector<boss::Decimal>(prices.size()));
+      boss::algorithm::times(priceSpan, discountSpan, products);
+      benchmark::DoNotOptimize(boss::algorithm::sum(products));
+    } else {
+      auto products = vector<double>(doublePrices.size());
+      std::transform(doublePrices.begin(), doublePrices.end(), doubleDiscounts.begin(),
+                     products.begin(), std::multiplies<>());
+      benchmark::DoNotOptimize(std::accumulate(products.begin(), products.end(), 0.0));
+    }
+  }
+}
+BENCHMARK_CAPTURE(Revenue, Decimal, true)->Range(1, 1U << 20U); // NOLINT
+BENCHMARK_CAPTURE(Revenue, Double, false)->Range(1, 1U << 20U); // NOLINT
+
+// a substring scan (as in the comment predicates of TPC-H Q13) over per-row and contiguous strings
+static void StringContains(benchmark::State& state, bool contiguous) {
+  auto comments = vector<string>(state.range(0));
+  for(auto i = 0U; i < comments.size(); i++) {
+    comments[i] = "carefully final deposits detect slyly " + to_string(i) +
+                  (i % 7 == 0 ? " special requests" : " furiously"); // NOLINT
+  }
+  auto rowStrings = boss::Span<string>(vector(comments));
+  auto contiguousStrings = boss::Span<string_view>(comments);
+  for(auto _ : state) { // NOLINT
+    auto matches = 0U;
+    if(contiguous) {
+      for(auto comment : contiguousStrings) {
+        matches += comment.find("special") != string_view::npos;
+      }
+    } else {
+      for(auto const& comment : rowStrings) {
+        matches += comment.find("special") != string::npos;
+      }
+    }
+    benchmark::DoNotOptimize(matches);
+  }
+}
+BENCHMARK_CAPTURE(StringContains, PerRow, false)->Range(1, 1U << 20U);    // NOLINT
+BENCHMARK_CAPTURE(StringContains, Contiguous, true)->Range(1, 1U << 20U); // NOLINT
+
+// sums a quantity-like column (values 1-50) through visitChunks, plain and encoded
+static void SumColumn(benchmark::State& state, std::optional<boss::Encoding> encoding) {
+  auto values = vector<int64_t>(state.range(0));
+  for(auto i = 0U; i < values.size(); i++) {
+    values[i] = 1 + int64_t(i * 7919 % 50); // NOLINT
+  }
+  auto spans = boss::expressions::ExpressionSpanArguments();
+  if(encoding) {
+    spans.emplace_back(boss::Span<boss::Encoded<int64_t>>(values, *encoding));
+  } else {
+    spans.emplace_back(boss::Span<int64_t>(std::move(values)));
+  }
+  auto const column = boss::ComplexExpression("List"_, {}, {}, std::move(spans));
+  for(auto _ : state) { // NOLINT
+    auto sum = int64_t(0);
+    column.visitChunks([&sum](auto const* data, size_t n) {
+      if constexpr(std::is_same_v<std::decay_t<decltype(*data)>, int64_t>) {
+        sum = std::accumulate(data, data + n, sum);
+      }
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+}
+BENCHMARK_CAPTURE(SumColumn, Plain, std::nullopt)->Range(1, 1U << 24U); // NOLINT
+BENCHMARK_CAPTURE(SumColumn, FrameOfReference, boss::Encoding::FrameOfReference) // NOLINT
+    ->Range(1, 1U << 24U);                                                       // NOLINT
+BENCHMARK_CAPTURE(SumColumn, Delta, boss::Encoding::Delta)->Range(1, 1U << 24U); // NOLINT
+
+// combines two predicate results and counts the selected rows, bit by bit and word-packed
+static void CombinePredicates(benchmark::State& state, bool packed) {
+  auto left = vector<bool>(state.range(0));
+  auto right = vector<bool>(state.range(0));
+  for(auto i = 0U; i < left.size(); i++) {
+    left[i] = i % 3 == 0;
+    right[i] = i % 7 < 4; // NOLINT
+  }
+  auto const packedLeft = boss::Span<boss::PackedBool>(left);
+  auto const packedRight = boss::Span<boss::PackedBool>(right);
+  auto const leftSpan = boss::Span<bool>(left);
+  auto const rightSpan = boss::Span<bool>(right);
+  for(auto _ : state) { // NOLINT
+    if(packed) {
+      benchmark::DoNotOptimize((packedLeft & packedRight).popcount());
+    } else {
+      auto selected = size_t(0);
+      for(auto i = 0U; i < leftSpan.size(); i++) {
+        selected += leftSpan[i] && rightSpan[i];
+      }
+      benchmark::DoNotOptimize(selected);
+    }
+  }
+}
+BENCHMARK_CAPTURE(CombinePredicates, BitByBit, false)->Range(1, 1U << 20U); // NOLINT
+BENCHMARK_CAPTURE(CombinePredicates, Packed, true)->Range(1, 1U << 20U);    // NOLINT
+
+// filters a wide table (as Q6 does LINEITEM) with a selective predicate and sums one of its
+// columns, copying every column or selecting views of them
+static void FilterWideTable(benchmark::State& state, bool views) {
+  auto const columnCount = 8U;
+  auto columns = vector<shared_ptr<boss::Span<double> const>>();
+  for(auto column = 0U; column < columnCount; column++) {
+    auto values = vector<double>(state.range(0));
+    for(auto i = 0U; i < values.size(); i++) {
+      values[i] = double(i % 100 + column); // NOLINT
+    }
+    columns.push_back(make_shared<boss::Span<double> const>(std::move(values)));
+  }
+  auto predicate = vector<bool>(state.range(0));
+  for(auto i = 0U; i < predicate.size(); i++) {
+    predicate[i] = i % 50 == 0; // NOLINT
+  }
+  auto const selection = boss::Span<boss::PackedBool>(predicate);
+  for(auto _ : state) { // NOLINT
+    auto filtered = boss::expressions::ExpressionSpanArguments();
+    auto const indices = boss::Span<boss::Selected<double>>::indicesOf(selection);
+    for(auto const& column : columns) {
+      if(views) {
+        filtered.emplace_back(boss::Span<boss::Selected<double>>(column, indices));
+      } else {
+        auto values = vector<double>();
+        selection.forEachSetBit([&](size_t i) { values.push_back((*column)[i]); });
+        filtered.emplace_back(boss::Span<double>(std::move(values)));
+      }
+    }
+    auto const table = boss::ComplexExpression("Table"_, {}, {}, std::move(filtered));
+    auto const& revenue = table.getSpanArguments().front();
+    benchmark::DoNotOptimize(std::visit(
+        [](auto const& span) {
+          return std::accumulate(span.begin(), span.end(), 0.0, [](double sum, auto const& v) {
+            if constexpr(std::is_arithmetic_v<std::decay_t<decltype(v)>>) {
+              return sum + double(v);
+            }
+            return sum;
+          });
+        },
+        revenue));
+  }
+}
+BENCHMARK_CAPTURE(FilterWideTable, Copied, false)->Range(1, 1U << 20U); // NOLINT
+BENCHMARK_CAPTURE(FilterWideTable, Views, true)->Range(1, 1U << 20U);   // NOLINT
+
+// sums a column that comes from a producer (standing in for a file reader), loading it into a
+// resident span first or streaming it through a generated span
+static void ScanProducedColumn(benchmark::State& state, bool streamed) {
+  auto const size = size_t(state.range(0));
+  auto const read = [](size_t begin, size_t n, int64_t* output) {
+    for(auto i = size_t(0); i < n; i++) {
+      output[i] = 1 + int64_t((begin + i) * 7919 % 50); // NOLINT
+    }
+  };
+  for(auto _ : state) { // NOLINT
+    auto spans = boss::expressions::ExpressionSpanArguments();
+    if(streamed) {
+      spans.emplace_back(boss::Span<boss::Generated<int64_t>>(size, read));
+    } else {
+      auto values = vector<int64_t>(size);
+      read(0, size, values.data());
+      spans.emplace_back(boss::Span<int64_t>(std::move(values)));
+    }
+    auto const column = boss::ComplexExpression("List"_, {}, {}, std::move(spans));
+    auto sum = int64_t(0);
+    column.visitChunks([&sum](auto const* data, size_t n) {
+      if constexpr(std::is_same_v<std::decay_t<decltype(*data)>, int64_t>) {
+        sum = std::accumulate(data, data + n, sum);
+      }
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+}
+BENCHMARK_CAPTURE(ScanProducedColumn, Loaded, false)->Range(1, 1U << 24U);  // NOLINT
+BENCHMARK_CAPTURE(ScanProducedColumn, Streamed, true)->Range(1, 1U << 24U); // NOLINT
+
+// interprets a balanced tree of integer arithmetic, the way the Readme's example engine does
+// (visiting every node and comparing its head to each operator name) and through an EngineBase
+static boss::Expression arithmeticTree(int depth) {
+  if(depth == 0) {
+    return int64_t(depth + 1);
+  }
+  static auto const heads = std::array<boss::Symbol, 3>{"Plus"_, "Times"_, "Minus"_};
+  return boss::ComplexExpression(heads[depth % heads.size()], {},
+                                 boss::ExpressionArguments(arithmeticTree(depth - 1),
+                                                           arithmeticTree(depth - 1)),
+                                 {});
+}
+
+static boss::Expression interpretByNames(boss::Expression&& e) {
+  return std::visit(
+      [](auto&& e) -> boss::Expression {
+        if constexpr(std::is_same_v<std::decay_t<decltype(e)>, boss::ComplexExpression>) {
+          auto [head, unused, arguments, spans] = std::move(e).decompose();
+          for(auto& argument : arguments) {
+            argument = interpretByNames(std::move(argument));
+          }
+          auto const left = std::get<int64_t>(arguments[0]);
+          auto const right = std::get<int64_t>(arguments[1]);
+          if(head == boss::Symbol("Plus")) {
+            return left + right;
+          }
+          if(head == boss::Symbol("Times")) {
+            return left * right;
+          }
+          if(head == boss::Symbol("Minus")) {
+            return left - right;
+          }
+          return boss::ComplexExpression(std::move(head), {}, std::move(arguments), {});
+        } else {
+          return std::forward<decltype(e)>(e);
+        }
+      },
+      std::move(e));
+}
+
+class ArithmeticEngine : public boss::EngineBase<ArithmeticEngine> {
+  using Operands = boss::ComplexExpressionWithStaticArguments<int64_t, int64_t>;
+
+public:
+  ArithmeticEngine() {
+    registerOperator<&ArithmeticEngine::plus>("Plus"_);
+    registerOperator<&ArithmeticEngine::times>("Times"_);
+    registerOperator<&ArithmeticEngine::minus>("Minus"_);
+  }
+  Expression plus(Operands&& e) {
+    return std::get<0>(e.getStaticArguments()) + std::get<1>(e.getStaticArguments());
+  }
+  Expression times(Operands&& e) {
+    return std::get<0>(e.getStaticArguments()) * std::get<1>(e.getStaticArguments());
+  }
+  Expression minus(Operands&& e) {
+    return std::get<0>(e.getStaticArguments()) - std::get<1>(e.getStaticArguments());
+  }
+};
+
+static void InterpretArithmetic(benchmark::State& state, bool engineBase) {
+  auto const tree = arithmeticTree(int(state.range(0)));
+  auto engine = ArithmeticEngine();
+  for(auto _ : state) { // NOLINT
+    state.PauseTiming();
+    auto expression = tree.clone(boss::expressions::CloneReason::FOR_TESTING);
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(engineBase ? engine.evaluate(std::move(expression))
+                                        : interpretByNames(std::move(expression)));
+  }
+}
+BENCHMARK_CAPTURE(InterpretArithmetic, ByNames, false)->DenseRange(8, 16, 4);    // NOLINT
+BENCHMARK_CAPTURE(InterpretArithmetic, EngineBase, true)->DenseRange(8, 16, 4); // NOLINT
+
+// sums a double column (the hottest aggregate, Plus over one span) with std::accumulate and with
+// the reduction kernels of each instruction set
+static void SumSpan(benchmark::State& state, std::optional<boss::algorithm::InstructionSet> set,
+                    boss::algorithm::Summation summation) {
+  if(set && !boss::algorithm::isSupported(*set)) {
+    state.SkipWithError("the processor does not support the instruction set");
+    return;
+  }
+  auto values = vector<double>(state.range(0));
+  for(auto i = 0U; i < values.size(); i++) {
+    values[i] = double(i % 1000) / 7; // NOLINT
+  }
+  auto const span = boss::Span<double const>(values);
+  for(auto _ : state) { // NOLINT
+    if(set) {
+      benchmark::DoNotOptimize(boss::algorithm::sum(span, summation, *set));
+    } else {
+      benchmark::DoNotOptimize(std::accumulate(span.begin(), span.end(), 0.0));
+    }
+  }
+}
+BENCHMARK_CAPTURE(SumSpan, Accumulate, std::nullopt, boss::algorithm::Summation::Fast) // NOLINT
+    ->Range(1, 1U << 24U);                                                            // NOLINT
+BENCHMARK_CAPTURE(SumSpan, Portable, boss::algorithm::InstructionSet::Portable,       // NOLINT
+                  boss::algorithm::Summation::Fast)
+    ->Range(1, 1U << 24U);                                                        // NOLINT
+BENCHMARK_CAPTURE(SumSpan, SSE2, boss::algorithm::InstructionSet::SSE2,           // NOLINT
+                  boss::algorithm::Summation::Fast)
+    ->Range(1, 1U << 24U);                                                        // NOLINT
+BENCHMARK_CAPTURE(SumSpan, AVX2, boss::algorithm::InstructionSet::AVX2,           // NOLINT
+                  boss::algorithm::Summation::Fast)
+    ->Range(1, 1U << 24U);                                                        // NOLINT
+BENCHMARK_CAPTURE(SumSpan, AVX512, boss::algorithm::InstructionSet::AVX512,       // NOLINT
+                  boss::algorithm::Summation::Fast)
+    ->Range(1, 1U << 24U);                                                        // NOLINT
+BENCHMARK_CAPTURE(SumSpan, AVX512_Deterministic, boss::algorithm::InstructionSet::AVX512, // NOLINT
+                  boss::algorithm::Summation::Deterministic)
+    ->Range(1, 1U << 24U); // NOLINT
+
+// the Where of TPC-H Q6 (shipdate, discount and quantity ranges) as one boolean column per
+// predicate combined with & and as one fused conjunction
+static void FilterQ6(benchmark::State& state, bool fused) {
+  auto shipdates = vector<int32_t>(state.range(0));
+  auto discounts = vector<double>(state.range(0));
+  auto quantities = vector<int64_t>(state.range(0));
+  for(auto i = 0U; i < shipdates.size(); i++) {
+    shipdates[i] = int32_t(8000 + i * 7919 % 2500); // NOLINT: days since 1970
+    discounts[i] = double(i * 104729 % 11) / 100;   // NOLINT
+    quantities[i] = 1 + int64_t(i * 31 % 50);       // NOLINT
+  }
+  auto const shipdate = boss::Span<int32_t const>(shipdates);
+  auto const discount = boss::Span<double const>(discounts);
+  auto const quantity = boss::Span<int64_t const>(quantities);
+  for(auto _ : state) { // NOLINT
+    auto const inYear = boss::algorithm::compare(shipdate, std::greater_equal<>(), 8766); // NOLINT
+    auto const beforeNextYear = boss::algorithm::compare(shipdate, std::less<>(), 9131); // NOLINT
+    auto const discounted = boss::algorithm::between(discount, 0.05, 0.07);               // NOLINT
+    auto const small = boss::algorithm::compare(quantity, std::less<>(), 24);             // NOLINT
+    if(fused) {
+      benchmark::DoNotOptimize(
+          boss::algorithm::filter(inYear, beforeNextYear, discounted, small).popcount());
+    } else {
+      benchmark::DoNotOptimize(
+          (boss::algorithm::filter(inYear) & boss::algorithm::filter(beforeNextYear) &
+           boss::algorithm::filter(discounted) & boss::algorithm::filter(small))
+              .popcount());
+    }
+  }
+}
+BENCHMARK_CAPTURE(FilterQ6, Separate, false)->Range(1, 1U << 24U); // NOLINT
+BENCHMARK_CAPTURE(FilterQ6, Fused, true)->Range(1, 1U << 24U);     // NOLINT
+
+// the revenue projection of TPC-H Q6 (extendedprice * discount) as a std::transform and with the
+// arithmetic kernels
+static void ProjectRevenue(benchmark::State& state, bool kernels) {
+  auto prices = vector<double>(state.range(0));
+  auto discounts = vector<double>(state.range(0));
+  for(auto i = 0U; i < prices.size(); i++) {
+    prices[i] = double(i % 100000) / 3;            // NOLINT
+    discounts[i] = double(i * 104729 % 11) / 100; // NOLINT
+  }
+  auto const price = boss::Span<double const>(prices);
+  auto const discount = boss::Span<double const>(discounts);
+  auto revenue = boss::Span<double>(vector<double>(prices.size()));
+  for(auto _ : state) { // NOLINT
+    if(kernels) {
+      boss::algorithm::times(price, discount, revenue);
+    } else {
+      std::transform(price.begin(), price.end(), discount.begin(), revenue.mutableBegin(),
+                     [](double a, double b) { return a * b; });
+    }
+    benchmark::DoNotOptimize(revenue[0]);
+  }
+}
+BENCHMARK_CAPTURE(ProjectRevenue, Transform, false)->Range(1, 1U << 24U); // NOLINT
+BENCHMARK_CAPTURE(ProjectRevenue, Kernels, true)->Range(1, 1U << 24U);    // NOLINT
+
+// hashes the (orderkey, linenumber) key of lineitem a row at a time (std::hash and hashCombine) and
+// with the batch hash kernels
+static void HashKeys(benchmark::State& state, bool kernels) {
+  auto orderKeys = vector<int64_t>(state.range(0));
+  auto lineNumbers = vector<int32_t>(state.range(0));
+  for(auto i = 0U; i < orderKeys.size(); i++) {
+    orderKeys[i] = int64_t(i / 4);  // NOLINT
+    lineNumbers[i] = int32_t(i % 4); // NOLINT
+  }
+  auto const orderKey = boss::Span<int64_t const>(orderKeys);
+  auto const lineNumber = boss::Span<int32_t const>(lineNumbers);
+  auto hashes = vector<uint64_t>(orderKeys.size());
+  for(auto _ : state) { // NOLINT
+    if(kernels) {
+      benchmark::DoNotOptimize(boss::algorithm::hash(orderKey, lineNumber));
+    } else {
+      for(auto i = 0U; i < hashes.size(); i++) {
+        hashes[i] = boss::utilities::hashCombine(std::hash<int64_t>{}(orderKey[i]),
+                                                 std::hash<int32_t>{}(lineNumber[i]));
+      }
+      benchmark::DoNotOptimize(hashes.data());
+    }
+  }
+}
+BENCHMARK_CAPTURE(HashKeys, PerRow, false)->Range(1, 1U << 24U); // NOLINT
+BENCHMARK_CAPTURE(HashKeys, Kernels, true)->Range(1, 1U << 24U); // NOLINT
+
+// sums (accumulate) and scales (transform) a 100M-row double column on a pool of 1 to N threads
+static void ParallelScan(benchmark::State& state, bool transform) {
+  auto values = vector<double>(100'000'000); // NOLINT
+  for(auto i = 0U; i < values.size(); i++) {
+    values[i] = double(i % 1000) / 7; // NOLINT
+  }
+  auto const span = boss::Span<double const>(values);
+  auto output = boss::Span<double>(vector<double>(transform ? values.size() : 0));
+  auto pool = boss::algorithm::ThreadPool(state.range(0));
+  auto const plus = [](double a, double b) { return a + b; };
+  for(auto _ : state) { // NOLINT
+    if(transform) {
+      boss::algorithm::parallelTransform(
+          span, output, [](double value) { return value * 2; }, pool);
+      benchmark::DoNotOptimize(output[0]);
+    } else {
+      benchmark::DoNotOptimize(boss::algorithm::parallelAccumulate(span, 0.0, plus, plus, pool));
+    }
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(values.size() * sizeof(double)));
+}
+BENCHMARK_CAPTURE(ParallelScan, Accumulate, false) // NOLINT
+    ->DenseRange(1, int(std::max(1U, std::thread::hardware_concurrency())))
+    ->UseRealTime();
+BENCHMARK_CAPTURE(ParallelScan, Transform, true) // NOLINT
+    ->DenseRange(1, int(std::max(1U, std::thread::hardware_concurrency())))
+    ->UseRealTime();
+
 BENCHMARK_MAIN(); // NOLINT
@@ -2,6 +2,28 @@
 
 #include "Expression.hpp"
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
 
 namespace boss::algorithm {
 template <typename Container, typename Visitor> void visitEach(Container c, Visitor v) {
@@ -42,4 +64,1503 @@ auto visitTransform(Container& c, TransformVisitor t) {
   });
 }
 
+/**
+ * A pool of threads that runs jobs split into morsels (ranges of elements that fit in cache). The
+ * morsels of a job are dealt out to the threads (the thread that runs the job takes part, too) in
+ * contiguous ranges, so that neighbouring morsels run on the same thread; a thread that runs out of
+ * morsels steals from the end of another thread's range. Jobs run one at a time (a job that is
+ * started from within a job runs on the thread that started it), and the first exception that a
+ * morsel throws is rethrown to the thread that ran the job (once the other threads have stopped)
+ */
+class ThreadPool {
+  struct Morsels {
+    std::mutex mutex;
+    size_t begin = 0;
+    size_t end = 0;
+  };
+  std::unique_ptr<Morsels[]> morsels; // NOLINT(*-avoid-c-arrays): per thread, [0] is the caller's
+  std::vector<std::thread> workers;
+
+  std::mutex jobMutex; // held while a job runs
+  std::mutex mutex;    // guards the fields below
+  std::condition_variable wake;
+  std::condition_variable done;
+  std::function<void(size_t)> const* job = nullptr;
+  size_t generation = 0;
+  size_t running = 0;
+  bool stopping = false;
+  std::exception_ptr failure;
+  std::atomic<bool> failed{false};
+
+  static ThreadPool*& current() {
+    thread_local ThreadPool* pool = nullptr;
+    return pool;
+  }
+
+  bool next(size_t thread, size_t& morsel) {
+    for(auto i = size_t(0); i < size(); i++) {
+      auto& range = morsels[(thread + i) % size()];
+      auto lock = std::lock_guard(range.mutex);
+      if(range.begin < range.end) {
+        morsel = i == 0 ? range.begin++ : --range.end; // steal from the end of other ranges
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void runMorsels(size_t thread) {
+    auto* const previous = std::exchange(current(), this);
+    for(auto morsel = size_t(0); !failed && next(thread, morsel);) {
+      try {
+        (*job)(morsel);
+      } catch(...) {
+        auto lock = std::lock_guard(mutex);
+        if(!failure) {
+          failure = std::current_exception();
+        }
+        failed = true;
+      }
+    }
+    current() = previous;
+  }
+
+  void work(size_t thread) {
+    auto lastGeneration = size_t(0);
+    while(true) {
+      auto lock = std::unique_lock(mutex);
+      wake.wait(lock, [&] { return stopping || generation != lastGeneration; });
+      if(stopping) {
+        return;
+      }
+      lastGeneration = generation;
+      lock.unlock();
+      runMorsels(thread);
+      lock.lock();
+      if(--running == 0) {
+        done.notify_one();
+      }
+    }
+  }
+
+public:
+  /**
+   * a pool of threads threads, including the ones that run jobs
+   */
+  explicit ThreadPool(size_t threads = std::max(1U, std::thread::hardware_concurrency()))
+      : morsels(new Morsels[std::max(size_t(1), threads)]) {
+    for(auto thread = size_t(1); thread < threads; thread++) {
+      workers.emplace_back([this, thread] { work(thread); });
+    }
+  }
+  ThreadPool(ThreadPool const&) = delete;
+  ThreadPool(ThreadPool&&) = delete;
+  ThreadPool& operator=(ThreadPool const&) = delete;
+  ThreadPool& operator=(ThreadPool&&) = delete;
+  ~ThreadPool() {
+    {
+      auto lock = std::lock_guard(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for(auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+  /**
+   * the pool that the parallel algorithms use unless they are given one (a thread per core)
+   */
+  static ThreadPool& shared() {
+    static auto pool = ThreadPool();
+    return pool;
+  }
+
+  size_t size() const { return workers.size() + 1; }
+
+  /**
+   * calls function(morsel) for every morsel in [0, count), in parallel, and returns when all calls
+   * have returned
+   */
+  template <typename Function> void forEachMorsel(size_t count, Function&& function) {
+    if(workers.empty() || current() == this) {
+      for(auto morsel = size_t(0); morsel < count; morsel++) {
+        function(morsel);
+      }
+      return;
+    }
+    auto jobLock = std::lock_guard(jobMutex);
+    for(auto thread = size_t(0); thread < size(); thread++) {
+      auto lock = std::lock_guard(morsels[thread].mutex);
+      morsels[thread].begin = count * thread / size();
+      morsels[thread].end = count * (thread + 1) / size();
+    }
+    auto const erased = std::function<void(size_t)>(std::ref(function));
+    {
+      auto lock = std::lock_guard(mutex);
+      job = &erased;
+      failure = nullptr;
+      failed = false;
+      running = workers.size();
+      generation++;
+    }
+    wake.notify_all();
+    runMorsels(0);
+    auto lock = std::unique_lock(mutex);
+    done.wait(lock, [this] { return running == 0; });
+    job = nullptr;
+    if(failure) {
+      std::rethrow_exception(failure);
+    }
+  }
+};
+
+/**
+ * the elements per morsel of a span of Scalars (64 KiB, so that a morsel stays in the L2 cache)
+ */
+template <typename Scalar>
+constexpr size_t morselSize = std::max(size_t(1), (size_t(1) << 16U) / sizeof(Scalar));
+
+namespace kernels {
+/**
+ * calls consume(begin, end) with iterators over the elements [first, last) of a span. Encoded and
+ * generated spans are decoded (produced) into a buffer first, as visitChunks does, rather than
+ * one element per dereference. Their elements are produced out of order and from several
+ * threads, so sequential spans are rejected
+ */
+template <typename Scalar, typename Consume>
+void visitMorsel(Span<Scalar> const& span, size_t first, size_t last, Consume&& consume) {
+  using Element = std::remove_const_t<typename Span<Scalar>::element_type>;
+  if constexpr(std::is_same_v<Scalar, Encoded<Element>> ||
+               std::is_same_v<Scalar, Generated<Element>>) {
+    auto block = std::make_unique<Element[]>(last - first); // NOLINT(*-avoid-c-arrays)
+    if constexpr(std::is_same_v<Scalar, Encoded<Element>>) {
+      span.decode(first, last - first, block.get());
+    } else {
+      if(span.isSequential()) {
+        throw std::invalid_argument(
+            "a sequential span cannot be visited in parallel, materialize it first");
+      }
+      span.produce(first, last - first, block.get());
+    }
+    consume(static_cast<Element const*>(block.get()),
+            static_cast<Element const*>(block.get() + (last - first)));
+  } else {
+    consume(span.begin() + first, span.begin() + last);
+  }
+}
+
+template <typename Scalar, typename Result, typename Transform>
+void parallelTransform(Span<Scalar> const& input, Result* results, Transform& transform,
+                       ThreadPool& pool) {
+  using Element = typename Span<Scalar>::element_type;
+  auto const morsels = (input.size() + morselSize<Element> - 1) / morselSize<Element>;
+  pool.forEachMorsel(morsels, [&](size_t morsel) {
+    auto const first = morsel * morselSize<Element>;
+    auto const last = std::min(first + morselSize<Element>, input.size());
+    visitMorsel(input, first, last, [&](auto begin, auto end) {
+      std::transform(begin, end, results + first, // NOLINT(*-pointer-arithmetic)
+                     transform);
+    });
+  });
+}
+} // namespace kernels
+
+/**
+ * Accumulates the elements of a span in parallel: each morsel is accumulated (with
+ * accumulate(state, element), starting from init) separately and the partial results are
+ * combined (with combine(left, right)) in the order of the morsels, so that the result does not
+ * depend on the number of threads. The producers of generated spans must be thread-safe
+ * (sequential spans throw a std::invalid_argument)
+ */
+template <typename Scalar, typename Init, typename Accumulate, typename Combine>
+Init parallelAccumulate(Span<Scalar> const& span, Init init, Accumulate accumulate,
+                        Combine combine, ThreadPool& pool = ThreadPool::shared()) {
+  using Element = typename Span<Scalar>::element_type;
+  auto const morsels = (span.size() + morselSize<Element> - 1) / morselSize<Element>;
+  auto partials = std::vector<std::optional<Init>>(morsels);
+  pool.forEachMorsel(morsels, [&](size_t morsel) {
+    auto const first = morsel * morselSize<Element>;
+    auto const last = std::min(first + morselSize<Element>, span.size());
+    kernels::visitMorsel(span, first, last, [&](auto begin, auto end) {
+      partials[morsel] = std::accumulate(begin, end, init, accumulate);
+    });
+  });
+  if(partials.empty()) {
+    return init;
+  }
+  auto result = std::move(*partials.front());
+  for(auto partial = partials.begin() + 1; partial != partials.end(); ++partial) {
+    result = combine(std::move(result), std::move(**partial));
+  }
+  return result;
+}
+
+/**
+ * Transforms the elements of a span in parallel, writing transform(element) into the output span
+ * (which must have the same size, its buffer is unshared before the threads write to it). The
+ * input is read as by parallelAccumulate
+ */
+template <typename InputScalar, typename OutputScalar, typename Transform>
+void parallelTransform(Span<InputScalar> const& input, Span<OutputScalar>& output,
+                       Transform transform, ThreadPool& pool = ThreadPool::shared()) {
+  static_assert(!std::is_const_v<OutputScalar> && !std::is_same_v<OutputScalar, bool>,
+                "parallelTransform writes to spans of (non-bool) mutable elements");
+  if(input.size() != output.size()) {
+    throw std::invalid_argument("cannot transform a span of size " + std::to_string(input.size()) +
+                                " into one of size " + std::to_string(output.size()));
+  }
+  if(output.size() > 0) {
+    kernels::parallelTransform(input, output.mutableBegin(), transform, pool);
+  }
+}
+
+/**
+ * The parallel counterpart of visitAccumulate over span arguments (e.g., the ExpressionSpanArguments
+ * of a column): the visitor is called with the state and the elements of each span (whatever its
+ * type), see parallelAccumulate
+ */
+template <typename Spans, typename Init, typename Visitor, typename Combine>
+Init parallelVisitAccumulate(Spans const& spans, Init init, Visitor visitor, Combine combine,
+                             ThreadPool& pool = ThreadPool::shared()) {
+  auto result = std::optional<Init>();
+  for(auto const& span : spans) {
+    auto partial = std::visit(
+        [&](auto const& typedSpan) {
+          return parallelAccumulate(typedSpan, init, visitor, combine, pool);
+        },
+        span);
+    result = result ? combine(std::move(*result), std::move(partial)) : std::move(partial);
+  }
+  return result ? std::move(*result) : init;
+}
+
+/**
+ * The parallel counterpart of visitTransform over span arguments: the transformed elements of the
+ * spans are written one after the other into the (pre-sized) output span, see parallelTransform
+ */
+template <typename Spans, typename OutputScalar, typename TransformVisitor>
+void parallelVisitTransform(Spans const& spans, Span<OutputScalar>& output,
+                            TransformVisitor transform, ThreadPool& pool = ThreadPool::shared()) {
+  static_assert(!std::is_const_v<OutputScalar> && !std::is_same_v<OutputScalar, bool>,
+                "parallelVisitTransform writes to spans of (non-bool) mutable elements");
+  auto size = size_t(0);
+  for(auto const& span : spans) {
+    size += std::visit([](auto const& typedSpan) { return typedSpan.size(); }, span);
+  }
+  if(size != output.size()) {
+    throw std::invalid_argument("cannot transform spans of size " + std::to_string(size) +
+                                " into one of size " + std::to_string(output.size()));
+  }
+  if(size == 0) {
+    return;
+  }
+  auto* results = output.mutableBegin();
+  for(auto const& span : spans) {
+    std::visit(
+        [&](auto const& typedSpan) {
+          kernels::parallelTransform(typedSpan, results, transform, pool);
+          results += typedSpan.size(); // NOLINT(*-pointer-arithmetic)
+        },
+        span);
+  }
+}
+
+/**
+ * The instruction sets that the numeric reduction kernels (below) are compiled for. A kernel is a
+ * loop over a fixed number of independent accumulators ("lanes", so that it vectorizes without
+ * reassociating floating-point additions), compiled once per instruction set with function-level
+ * target attributes (so the library needs no instruction-set-specific build flags) and picked at
+ * runtime for the processor at hand. Portable is the only variant that is compiled for processors
+ * other than x86 (and compilers other than GCC and Clang): it is compiled for whatever the build
+ * targets
+ */
+enum class InstructionSet { Portable, SSE2, AVX2, AVX512 };
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BOSS_X86_KERNELS
+#define BOSS_KERNEL_TARGET(features) __attribute__((target(features)))
+#define BOSS_KERNEL_INLINE __attribute__((always_inline)) inline
+#else
+#define BOSS_KERNEL_INLINE inline
+#endif
+
+/**
+ * the best instruction set that this processor supports (detected once, using CPUID)
+ */
+inline InstructionSet supportedInstructionSet() {
+#ifdef BOSS_X86_KERNELS
+  static auto const supported = [] {
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")) {
+      return InstructionSet::AVX512;
+    }
+    if(__builtin_cpu_supports("avx2")) {
+      return InstructionSet::AVX2;
+    }
+    return InstructionSet::SSE2;
+  }();
+  return supported;
+#else
+  return InstructionSet::Portable;
+#endif
+}
+inline bool isSupported(InstructionSet instructionSet) {
+  return instructionSet == InstructionSet::Portable ||
+         (supportedInstructionSet() != InstructionSet::Portable &&
+          instructionSet <= supportedInstructionSet());
+}
+
+/**
+ * How floating-point sums are accumulated. Fast uses as many lanes as it takes to keep the
+ * instruction set's adders busy, so the rounding (i.e., the last bits of the sum) may differ
+ * between processors. Deterministic uses the same lanes (and adds them up in the same order) with
+ * every instruction set, so the sum of a span has the same bits on every processor. Integer sums
+ * (and minima and maxima) are exact either way
+ */
+enum class Summation { Fast, Deterministic };
+
+namespace kernels {
+using expressions::Bitmap;
+using expressions::ValidityBitmap;
+
+template <typename Value> struct Sum {
+  using Accumulator = std::conditional_t<std::is_integral_v<Value>, std::int64_t, std::double_t>;
+  static constexpr Accumulator identity = 0;
+  static Accumulator combine(Accumulator a, Accumulator b) { return a + b; }
+};
+template <typename Value> struct Min {
+  using Accumulator = Value;
+  static constexpr Accumulator identity = std::numeric_limits<Value>::has_infinity
+                                              ? std::numeric_limits<Value>::infinity()
+                                              : std::numeric_limits<Value>::max();
+  static Accumulator combine(Accumulator a, Accumulator b) { return b < a ? b : a; }
+};
+template <typename Value> struct Max {
+  using Accumulator = Value;
+  static constexpr Accumulator identity = std::numeric_limits<Value>::has_infinity
+                                              ? -std::numeric_limits<Value>::infinity()
+                                              : std::numeric_limits<Value>::lowest();
+  static Accumulator combine(Accumulator a, Accumulator b) { return b > a ? b : a; }
+};
+
+/**
+ * the validity of the elements [block * 64, block * 64 + 64)
+ */
+inline Bitmap::Word validWord(ValidityBitmap const& validity, size_t block) {
+  return validity.isPresent() ? validity.getBits().word(block) : ~Bitmap::Word(0);
+}
+
+/**
+ * Reduces the values a block of 64 (i.e., a validity word) at a time: blocks without missing
+ * values go through a plain loop over the lanes, blocks with some missing values through one that
+ * selects the identity for them. The elements after the last full block go to the lanes in the
+ * same order, and the lanes are folded pairwise, so the result only depends on the number of lanes
+ */
+template <typename Reduction, size_t Lanes, typename Value>
+BOSS_KERNEL_INLINE typename Reduction::Accumulator
+reduce(Value const* values, size_t size, ValidityBitmap const& validity) {
+  using Accumulator = typename Reduction::Accumulator;
+  constexpr auto blockSize = Bitmap::bitsPerWord;
+  static_assert(blockSize % Lanes == 0, "the lanes must divide the blocks");
+  Accumulator lanes[Lanes]; // NOLINT(*-avoid-c-arrays)
+  for(auto& lane : lanes) {
+    lane = Reduction::identity;
+  }
+  auto const blocks = size / blockSize;
+  for(auto block = size_t(0); block < blocks; block++) {
+    auto const* blockValues = values + block * blockSize; // NOLINT(*-pointer-arithmetic)
+    auto const valid = validWord(validity, block);
+    if(valid == ~Bitmap::Word(0)) {
+      for(auto i = size_t(0); i < blockSize; i += Lanes) {
+        for(auto lane = size_t(0); lane < Lanes; lane++) {
+          lanes[lane] = Reduction::combine(lanes[lane], Accumulator(blockValues[i + lane]));
+        }
+      }
+    } else if(valid != 0) {
+      for(auto i = size_t(0); i < blockSize; i += Lanes) {
+        for(auto lane = size_t(0); lane < Lanes; lane++) {
+          lanes[lane] = Reduction::combine(lanes[lane], (valid >> (i + lane) & 1U) != 0
+                                                            ? Accumulator(blockValues[i + lane])
+                                                            : Reduction::identity);
+        }
+      }
+    }
+  }
+  for(auto i = blocks * blockSize; i < size; i++) {
+    if(validity.isValid(i)) {
+      lanes[i % Lanes] = Reduction::combine(lanes[i % Lanes], Accumulator(values[i]));
+    }
+  }
+  for(auto width = Lanes / 2; width > 0; width /= 2) {
+    for(auto lane = size_t(0); lane < width; lane++) {
+      lanes[lane] = Reduction::combine(lanes[lane], lanes[lane + width]);
+    }
+  }
+  return lanes[0];
+}
+
+/**
+ * The exact sum of 64-bit integers (or of the unscaled values of decimals), as a 96-bit integer:
+ * high * 2^32 + low. The high (signed) and low (unsigned) 32-bit halves are accumulated in
+ * separate lanes, which cannot overflow within a block and are carried into the result after every
+ * block
+ */
+struct WideSum {
+  std::int64_t high = 0; // in units of 2^32
+  std::uint64_t low = 0; // always less than 2^32
+
+  bool fitsInt64() const { return (high >= INT32_MIN) && (high <= INT32_MAX); }
+  std::int64_t toInt64() const {
+    return static_cast<std::int64_t>(static_cast<std::uint64_t>(high) << 32U | low);
+  }
+  std::double_t toDouble() const {
+    constexpr auto twoToThe32 = 4294967296.0;
+    return std::double_t(high) * twoToThe32 + std::double_t(low);
+  }
+};
+BOSS_KERNEL_INLINE std::int64_t wideValue(std::int64_t value) { return value; }
+BOSS_KERNEL_INLINE std::int64_t wideValue(Decimal value) { return value.getUnscaledValue(); }
+
+template <size_t Lanes, typename Value>
+BOSS_KERNEL_INLINE WideSum wideSum(Value const* values, size_t size,
+                                   ValidityBitmap const& validity) {
+  constexpr auto halfBits = 32U;
+  constexpr auto lowMask = (std::uint64_t(1) << halfBits) - 1;
+  constexpr auto blockSize = Bitmap::bitsPerWord;
+  constexpr auto carryBlocks = size_t(1) << 24U; // the lanes' block sums stay below 2^63
+  static_assert(blockSize % Lanes == 0, "the lanes must divide the blocks");
+  auto result = WideSum();
+  auto const carry = [&result](std::int64_t high, std::uint64_t low) {
+    result.low += low & lowMask;
+    result.high += high + static_cast<std::int64_t>(low >> halfBits) +
+                   static_cast<std::int64_t>(result.low >> halfBits);
+    result.low &= lowMask;
+  };
+  auto const blocks = size / blockSize;
+  for(auto first = size_t(0); first < blocks; first += carryBlocks) {
+    std::int64_t highs[Lanes] = {}; // NOLINT(*-avoid-c-arrays)
+    std::uint64_t lows[Lanes] = {}; // NOLINT(*-avoid-c-arrays)
+    for(auto block = first; block < std::min(first + carryBlocks, blocks); block++) {
+      auto const* blockValues = values + block * blockSize; // NOLINT(*-pointer-arithmetic)
+      auto const valid = validWord(validity, block);
+      for(auto i = size_t(0); i < blockSize; i += Lanes) {
+        for(auto lane = size_t(0); lane < Lanes; lane++) {
+          auto const value =
+              (valid >> (i + lane) & 1U) != 0 ? wideValue(blockValues[i + lane]) : std::int64_t(0);
+          highs[lane] += value >> halfBits; // NOLINT(hicpp-signed-bitwise)
+          lows[lane] += static_cast<std::uint64_t>(value) & lowMask;
+        }
+      }
+    }
+    for(auto lane = size_t(0); lane < Lanes; lane++) {
+      carry(highs[lane], lows[lane]);
+    }
+  }
+  for(auto i = blocks * blockSize; i < size; i++) {
+    if(validity.isValid(i)) {
+      auto const value = wideValue(values[i]); // NOLINT(*-pointer-arithmetic)
+      carry(value >> halfBits, static_cast<std::uint64_t>(value) & lowMask); // NOLINT
+    }
+  }
+  return result;
+}
+
+/**
+ * the lanes that keep an instruction set with vectors of VectorBytes busy (four vectors, to hide
+ * the latency of the additions)
+ */
+template <typename Accumulator, size_t VectorBytes>
+constexpr size_t lanesFor = std::min(size_t(64), 4 * VectorBytes / sizeof(Accumulator));
+constexpr size_t deterministicLanes = 16;
+
+#ifdef BOSS_X86_KERNELS
+template <typename Reduction, size_t Lanes, typename Value>
+BOSS_KERNEL_TARGET("avx512f,avx512bw,avx512dq,avx512vl")
+typename Reduction::Accumulator
+    reduceAVX512(Value const* values, size_t size, ValidityBitmap const& validity) {
+  return reduce<Reduction, Lanes>(values, size, validity);
+}
+template <typename Reduction, size_t Lanes, typename Value>
+BOSS_KERNEL_TARGET("avx2") typename Reduction::Accumulator
+    reduceAVX2(Value const* values, size_t size, ValidityBitmap const& validity) {
+  return reduce<Reduction, Lanes>(values, size, validity);
+}
+template <size_t Lanes, typename Value>
+BOSS_KERNEL_TARGET("avx512f,avx512bw,avx512dq,avx512vl")
+WideSum wideSumAVX512(Value const* values, size_t size, ValidityBitmap const& validity) {
+  return wideSum<Lanes>(values, size, validity);
+}
+template <size_t Lanes, typename Value>
+BOSS_KERNEL_TARGET("avx2")
+WideSum wideSumAVX2(Value const* values, size_t size, ValidityBitmap const& validity) {
+  return wideSum<Lanes>(values, size, validity);
+}
+#endif
+
+/**
+ * runs the variant of the reduction for the instruction set (the lanes of floating-point sums are
+ * fixed for deterministic summation, see Summation)
+ */
+template <typename Reduction, typename Value>
+typename Reduction::Accumulator dispatch(Value const* values, size_t size,
+                                         ValidityBitmap const& validity, Summation summation,
+                                         InstructionSet instructionSet) {
+  using Accumulator = typename Reduction::Accumulator;
+  auto const deterministic = summation == Summation::Deterministic &&
+                             std::is_floating_point_v<Accumulator> &&
+                             std::is_same_v<Reduction, Sum<Value>>;
+  if(!isSupported(instructionSet)) {
+    throw std::invalid_argument("the processor does not support the requested instruction set");
+  }
+  switch(instructionSet) {
+#ifdef BOSS_X86_KERNELS
+  case InstructionSet::AVX512:
+    return deterministic
+               ? reduceAVX512<Reduction, deterministicLanes>(values, size, validity)
+               : reduceAVX512<Reduction, lanesFor<Accumulator, 64>>(values, size, validity);
+  case InstructionSet::AVX2:
+    return deterministic ? reduceAVX2<Reduction, deterministicLanes>(values, size, validity)
+                         : reduceAVX2<Reduction, lanesFor<Accumulator, 32>>(values, size, validity);
+  case InstructionSet::SSE2: // the x86-64 baseline, which the build targets anyway
+    return deterministic ? reduce<Reduction, deterministicLanes>(values, size, validity)
+                         : reduce<Reduction, lanesFor<Accumulator, 16>>(values, size, validity);
+#endif
+  default:
+    return reduce<Reduction, deterministicLanes>(values, size, validity);
+  }
+}
+template <typename Value>
+WideSum dispatchWideSum(Value const* values, size_t size, ValidityBitmap const& validity,
+                        InstructionSet instructionSet) {
+  if(!isSupported(instructionSet)) {
+    throw std::invalid_argument("the processor does not support the requested instruction set");
+  }
+  switch(instructionSet) {
+#ifdef BOSS_X86_KERNELS
+  case InstructionSet::AVX512:
+    return wideSumAVX512<lanesFor<std::int64_t, 64>>(values, size, validity);
+  case InstructionSet::AVX2:
+    return wideSumAVX2<lanesFor<std::int64_t, 32>>(values, size, validity);
+#endif
+  default:
+    return wideSum<lanesFor<std::int64_t, 16>>(values, size, validity);
+  }
+}
+
+template <typename Scalar>
+constexpr bool isNumeric =
+    std::is_same_v<Scalar, std::int32_t> || std::is_same_v<Scalar, std::int64_t> ||
+    std::is_same_v<Scalar, std::float_t> || std::is_same_v<Scalar, std::double_t>;
+/**
+ * the types the comparison kernels accept: numbers, and dates and decimals (which compare as their
+ * underlying integers, i.e., days since the epoch and unscaled values)
+ */
+template <typename Scalar>
+constexpr bool isComparable =
+    isNumeric<Scalar> || std::is_same_v<Scalar, Date> || std::is_same_v<Scalar, Decimal>;
+} // namespace kernels
+
+/**
+ * The number of valid (i.e., not missing) elements, which the validity bitmap already knows
+ */
+template <typename Scalar> size_t count(Span<Scalar> const& span) {
+  return span.size() - span.nullCount();
+}
+
+/**
+ * The sum of the valid elements of a numeric span (of 32 or 64-bit integers or floats). 32-bit
+ * integers are summed in 64-bit lanes and 64-bit integers exactly (see kernels::WideSum), so
+ * neither can overflow on the way; throws std::overflow_error if the sum of 64-bit integers does
+ * not fit one. Floats are summed in doubles (see Summation for their rounding)
+ */
+template <typename Scalar>
+std::enable_if_t<kernels::isNumeric<std::remove_const_t<Scalar>>,
+                 typename kernels::Sum<std::remove_const_t<Scalar>>::Accumulator>
+sum(Span<Scalar> const& span, Summation summation = Summation::Fast,
+    InstructionSet instructionSet = supportedInstructionSet()) {
+  using Value = std::remove_const_t<Scalar>;
+  if constexpr(std::is_same_v<Value, std::int64_t>) {
+    auto const wide = kernels::dispatchWideSum(span.begin(), span.size(), span.getValidity(),
+                                               instructionSet);
+    if(!wide.fitsInt64()) {
+      throw std::overflow_error("the sum of the integers does not fit a 64-bit integer");
+    }
+    return wide.toInt64();
+  } else {
+    return kernels::dispatch<kernels::Sum<Value>>(span.begin(), span.size(), span.getValidity(),
+                                                  summation, instructionSet);
+  }
+}
+
+namespace kernels {
+/**
+ * The minimum or maximum of the valid elements of a span (which has some). The reductions skip
+ * NaNs, so their result is the (infinite) identity if every valid element is NaN as well as if the
+ * extremum is infinite: only then are the elements searched for the identity, and the result is NaN
+ * if it is not among them
+ */
+template <typename Reduction, typename Scalar>
+std::remove_const_t<Scalar> extremum(Span<Scalar> const& span, InstructionSet instructionSet) {
+  using Value = std::remove_const_t<Scalar>;
+  auto const result = dispatch<Reduction>(span.begin(), span.size(), span.getValidity(),
+                                          Summation::Fast, instructionSet);
+  if constexpr(std::is_floating_point_v<Value>) {
+    if(result == Reduction::identity) {
+      for(auto i = size_t(0); i < span.size(); i++) {
+        if(span.getValidity().isValid(i) && span[i] == result) {
+          return result;
+        }
+      }
+      return std::numeric_limits<Value>::quiet_NaN();
+    }
+  }
+  return result;
+}
+} // namespace kernels
+
+/**
+ * The smallest valid element of a numeric span (NaNs are skipped, and the result is NaN if every
+ * valid element is NaN), if it has any
+ */
+template <typename Scalar>
+std::enable_if_t<kernels::isNumeric<std::remove_const_t<Scalar>>,
+                 std::optional<std::remove_const_t<Scalar>>>
+min(Span<Scalar> const& span, InstructionSet instructionSet = supportedInstructionSet()) {
+  if(count(span) == 0) {
+    return {};
+  }
+  return kernels::extremum<kernels::Min<std::remove_const_t<Scalar>>>(span, instructionSet);
+}
+
+/**
+ * The largest valid element of a numeric span (NaNs are skipped, and the result is NaN if every
+ * valid element is NaN), if it has any
+ */
+template <typename Scalar>
+std::enable_if_t<kernels::isNumeric<std::remove_const_t<Scalar>>,
+                 std::optional<std::remove_const_t<Scalar>>>
+max(Span<Scalar> const& span, InstructionSet instructionSet = supportedInstructionSet()) {
+  if(count(span) == 0) {
+    return {};
+  }
+  return kernels::extremum<kernels::Max<std::remove_const_t<Scalar>>>(span, instructionSet);
+}
+
+/**
+ * The mean of the valid elements of a numeric span, if it has any. Unlike sum, the mean of 64-bit
+ * integers is taken from their exact (wide) sum, so it cannot overflow
+ */
+template <typename Scalar>
+std::enable_if_t<kernels::isNumeric<std::remove_const_t<Scalar>>, std::optional<std::double_t>>
+mean(Span<Scalar> const& span, Summation summation = Summation::Fast,
+     InstructionSet instructionSet = supportedInstructionSet()) {
+  auto const valid = count(span);
+  if(valid == 0) {
+    return {};
+  }
+  if constexpr(std::is_same_v<std::remove_const_t<Scalar>, std::int64_t>) {
+    auto const wide = kernels::dispatchWideSum(span.begin(), span.size(), span.getValidity(),
+                                               instructionSet);
+    return wide.toDouble() / std::double_t(valid);
+  } else {
+    return std::double_t(sum(span, summation, instructionSet)) / std::double_t(valid);
+  }
+}
+
+namespace kernels {
+/**
+ * A predicate on the elements of a column, evaluated a block of 64 (i.e., a bitmap word) at a
+ * time. Missing elements do not satisfy it
+ */
+template <typename Value, typename Condition> struct ColumnPredicate {
+  Value const* values;
+  size_t size;
+  ValidityBitmap validity;
+  Condition condition;
+
+  BOSS_KERNEL_INLINE Bitmap::Word word(size_t block) const {
+    constexpr auto blockSize = Bitmap::bitsPerWord;
+    auto const* blockValues = values + block * blockSize; // NOLINT(*-pointer-arithmetic)
+    auto result = Bitmap::Word(0);
+    if((block + 1) * blockSize <= size) {
+      for(auto i = size_t(0); i < blockSize; i++) {
+        result |= Bitmap::Word(condition(blockValues[i])) << i;
+      }
+    } else {
+      for(auto i = size_t(0); i < size - block * blockSize; i++) {
+        result |= Bitmap::Word(condition(blockValues[i])) << i;
+      }
+    }
+    return result & validWord(validity, block);
+  }
+};
+
+/**
+ * A comparison of the elements of two columns (of the same size), see ColumnPredicate
+ */
+template <typename Left, typename Right, typename Operator> struct ColumnsPredicate {
+  Left const* left;
+  Right const* right;
+  size_t size;
+  ValidityBitmap leftValidity;
+  ValidityBitmap rightValidity;
+  Operator op;
+
+  BOSS_KERNEL_INLINE Bitmap::Word word(size_t block) const {
+    constexpr auto blockSize = Bitmap::bitsPerWord;
+    auto const* leftValues = left + block * blockSize;   // NOLINT(*-pointer-arithmetic)
+    auto const* rightValues = right + block * blockSize; // NOLINT(*-pointer-arithmetic)
+    auto result = Bitmap::Word(0);
+    if((block + 1) * blockSize <= size) {
+      for(auto i = size_t(0); i < blockSize; i++) {
+        result |= Bitmap::Word(op(leftValues[i], rightValues[i])) << i;
+      }
+    } else {
+      for(auto i = size_t(0); i < size - block * blockSize; i++) {
+        result |= Bitmap::Word(op(leftValues[i], rightValues[i])) << i;
+      }
+    }
+    return result & validWord(leftValidity, block) & validWord(rightValidity, block);
+  }
+};
+
+/**
+ * The words [first, first + count) of the conjunction of the predicates. A block that fails a
+ * predicate is not tested against the ones after it
+ */
+template <typename... Predicates>
+BOSS_KERNEL_INLINE void conjunction(Bitmap::Word* output, size_t first, size_t count,
+                                    Predicates const&... predicates) {
+  for(auto block = first; block < first + count; block++) {
+    auto result = ~Bitmap::Word(0);
+    (void)((result &= predicates.word(block), result != 0) && ...); // stops at a zero word
+    output[block - first] = result; // NOLINT(*-pointer-arithmetic)
+  }
+}
+
+#ifdef BOSS_X86_KERNELS
+template <typename... Predicates>
+BOSS_KERNEL_TARGET("avx512f,avx512bw,avx512dq,avx512vl")
+void conjunctionAVX512(Bitmap::Word* output, size_t first, size_t count,
+                       Predicates const&... predicates) {
+  conjunction(output, first, count, predicates...);
+}
+template <typename... Predicates>
+BOSS_KERNEL_TARGET("avx2")
+void conjunctionAVX2(Bitmap::Word* output, size_t first, size_t count,
+                     Predicates const&... predicates) {
+  conjunction(output, first, count, predicates...);
+}
+#endif
+
+template <typename... Predicates>
+void dispatchConjunction(InstructionSet instructionSet, Bitmap::Word* output, size_t first,
+                         size_t count, Predicates const&... predicates) {
+  switch(instructionSet) {
+#ifdef BOSS_X86_KERNELS
+  case InstructionSet::AVX512:
+    conjunctionAVX512(output, first, count, predicates...);
+    return;
+  case InstructionSet::AVX2:
+    conjunctionAVX2(output, first, count, predicates...);
+    return;
+#endif
+  default:
+    conjunction(output, first, count, predicates...);
+  }
+}
+
+/**
+ * the size of the predicates' columns (which must be the same)
+ */
+template <typename Predicate, typename... Predicates>
+size_t commonSize(InstructionSet instructionSet, Predicate const& predicate,
+                  Predicates const&... predicates) {
+  if(!isSupported(instructionSet)) {
+    throw std::invalid_argument("the processor does not support the requested instruction set");
+  }
+  if(((predicates.size != predicate.size) || ...)) {
+    throw std::invalid_argument("cannot combine predicates on columns of different sizes");
+  }
+  return predicate.size;
+}
+} // namespace kernels
+
+/**
+ * Compares the elements of a numeric (or date or decimal) column with a constant, e.g.,
+ * compare(quantities, std::less<>(), 24) or compare(shipDates, std::less<>(), Date("1995-01-01"))
+ * -- with std::less<>, std::less_equal<>, std::equal_to<>, std::not_equal_to<>, std::greater<> or
+ * std::greater_equal<>. The predicate refers to (does not copy) the column: evaluate it with
+ * filter or select while the column is alive
+ */
+template <typename Scalar, typename Operator>
+auto compare(Span<Scalar> const& column, Operator op, std::remove_const_t<Scalar> constant) {
+  using Value = std::remove_const_t<Scalar>;
+  static_assert(kernels::isComparable<Value>, "compare expects a numeric, date or decimal column");
+  auto condition = [op, constant](Value value) { return op(value, constant); };
+  return kernels::ColumnPredicate<Value, decltype(condition)>{
+      column.begin(), column.size(), column.getValidity(), condition};
+}
+
+/**
+ * Compares the elements of two columns of the same size, e.g., compare(commitDates,
+ * std::less<>(), receiptDates), see compare. Numeric columns of different types can be compared,
+ * date and decimal columns only with columns of their own type
+ */
+template <typename LeftScalar, typename RightScalar, typename Operator>
+auto compare(Span<LeftScalar> const& left, Operator op, Span<RightScalar> const& right) {
+  using Left = std::remove_const_t<LeftScalar>;
+  using Right = std::remove_const_t<RightScalar>;
+  static_assert((kernels::isNumeric<Left> && kernels::isNumeric<Right>) ||
+                    (kernels::isComparable<Left> && std::is_same_v<Left, Right>),
+                "compare expects numeric columns, or date or decimal columns of the same type");
+  if(left.size() != right.size()) {
+    throw std::invalid_argument("cannot compare columns of sizes " + std::to_string(left.size()) +
+                                " and " + std::to_string(right.size()));
+  }
+  return kernels::ColumnsPredicate<Left, Right, Operator>{
+      left.begin(), right.begin(), left.size(), left.getValidity(), right.getValidity(), op};
+}
+
+/**
+ * The elements of a numeric (or date or decimal) column in [low, high] (as in SQL's BETWEEN), see
+ * compare
+ */
+template <typename Scalar>
+auto between(Span<Scalar> const& column, std::remove_const_t<Scalar> low,
+             std::remove_const_t<Scalar> high) {
+  using Value = std::remove_const_t<Scalar>;
+  static_assert(kernels::isComparable<Value>, "between expects a numeric, date or decimal column");
+  auto condition = [low, high](Value value) { // & rather than &&, so that it has no branches
+    return (low <= value) & (value <= high);    // NOLINT(hicpp-signed-bitwise)
+  };
+  return kernels::ColumnPredicate<Value, decltype(condition)>{
+      column.begin(), column.size(), column.getValidity(), condition};
+}
+
+/**
+ * The conjunction of the predicates (see compare and between) as a word-packed boolean column.
+ * The predicates are fused: each block of 64 rows is tested against all of them before the next,
+ * so no boolean column is materialized per predicate
+ */
+template <typename... Predicates>
+Span<PackedBool> filter(InstructionSet instructionSet, Predicates const&... predicates) {
+  using expressions::Bitmap;
+  auto const size = kernels::commonSize(instructionSet, predicates...);
+  auto words = std::vector<Bitmap::Word>((size + Bitmap::bitsPerWord - 1) / Bitmap::bitsPerWord);
+  kernels::dispatchConjunction(instructionSet, words.data(), 0, words.size(), predicates...);
+  return Span<PackedBool>(Bitmap(std::move(words), size));
+}
+template <typename Predicate, typename... Predicates>
+std::enable_if_t<!std::is_same_v<Predicate, InstructionSet>, Span<PackedBool>>
+filter(Predicate const& predicate, Predicates const&... predicates) {
+  return filter(supportedInstructionSet(), predicate, predicates...);
+}
+
+/**
+ * The conjunction of the predicates as a selection vector (the indices of the rows that satisfy
+ * all of them, e.g., for Span<Selected<Scalar>>), see filter. The words are evaluated a chunk at a
+ * time and turned into indices while they are in cache
+ */
+template <typename... Predicates>
+std::vector<std::uint32_t> select(InstructionSet instructionSet, Predicates const&... predicates) {
+  using expressions::Bitmap;
+  constexpr auto chunkWords = size_t(64);
+  auto const size = kernels::commonSize(instructionSet, predicates...);
+  if(size > std::numeric_limits<std::uint32_t>::max()) {
+    throw std::length_error("a selection vector cannot index more than 2^32 rows");
+  }
+  auto const wordCount = (size + Bitmap::bitsPerWord - 1) / Bitmap::bitsPerWord;
+  auto selection = std::vector<std::uint32_t>();
+  auto words = std::array<Bitmap::Word, chunkWords>();
+  for(auto first = size_t(0); first < wordCount; first += chunkWords) {
+    auto const count = std::min(chunkWords, wordCount - first);
+    kernels::dispatchConjunction(instructionSet, words.data(), first, count, predicates...);
+    for(auto word = size_t(0); word < count; word++) {
+      for(auto bits = words[word]; bits != 0; bits &= bits - 1) {
+        selection.push_back(std::uint32_t(
+            (first + word) * Bitmap::bitsPerWord +
+            std::bitset<Bitmap::bitsPerWord>((bits & (~bits + 1)) - 1).count()));
+      }
+    }
+  }
+  return selection;
+}
+template <typename Predicate, typename... Predicates>
+std::enable_if_t<!std::is_same_v<Predicate, InstructionSet>, std::vector<std::uint32_t>>
+select(Predicate const& predicate, Predicates const&... predicates) {
+  return select(supportedInstructionSet(), predicate, predicates...);
+}
+
+/**
+ * How integer (and decimal) arithmetic (see plus, minus, times and divide) treats results that do
+ * not fit the (64-bit) result: Wrap wraps them around (two's complement), Check throws
+ * std::overflow_error.
+ * Checking costs a few instructions per element, which the loops hide for sums and differences.
+ * 32-bit integers are promoted to 64 bits before the operation, so sums, differences and products
+ * of them cannot overflow (and are not checked)
+ */
+enum class IntegerOverflow { Wrap, Check };
+
+/**
+ * The type of the result of arithmetic on Left and Right, following the promotion of
+ * ExpressionWithAdditionalCustomAtoms: integers are promoted to 64-bit integers, floats to doubles
+ * (as are integers that meet floats). Decimals only meet decimals and stay decimals
+ */
+template <typename Left, typename Right>
+using Promoted = std::conditional_t<
+    std::is_same_v<Left, Decimal> || std::is_same_v<Right, Decimal>, Decimal,
+    std::conditional_t<std::is_integral_v<Left> && std::is_integral_v<Right>, std::int64_t,
+                       std::double_t>>;
+
+namespace kernels {
+template <typename Integer> using Unsigned = std::make_unsigned_t<Integer>;
+/**
+ * whether the arithmetic on Value is integer arithmetic that can overflow (see IntegerOverflow)
+ */
+template <typename Value>
+constexpr bool isExact = std::is_integral_v<Value> || std::is_same_v<Value, Decimal>;
+
+struct Plus {
+  template <typename Value> static BOSS_KERNEL_INLINE Value apply(Value a, Value b) {
+    if constexpr(std::is_integral_v<Value>) { // wraps around rather than overflowing (UB)
+      return static_cast<Value>(static_cast<Unsigned<Value>>(a) + static_cast<Unsigned<Value>>(b));
+    } else {
+      return a + b; // decimals wrap around, too
+    }
+  }
+  template <typename Value> static BOSS_KERNEL_INLINE bool overflows(Value a, Value b, Value r) {
+    if constexpr(std::is_same_v<Value, Decimal>) {
+      return a.sumOverflows(b);
+    } else {
+      return ((a ^ r) & (b ^ r)) < 0; // NOLINT(hicpp-signed-bitwise): the sign flipped
+    }
+  }
+  template <typename Value> static BOSS_KERNEL_INLINE bool undefined(Value /*a*/, Value /*b*/) {
+    return false;
+  }
+};
+struct Minus {
+  template <typename Value> static BOSS_KERNEL_INLINE Value apply(Value a, Value b) {
+    if constexpr(std::is_integral_v<Value>) {
+      return static_cast<Value>(static_cast<Unsigned<Value>>(a) - static_cast<Unsigned<Value>>(b));
+    } else {
+      return a - b;
+    }
+  }
+  template <typename Value> static BOSS_KERNEL_INLINE bool overflows(Value a, Value b, Value r) {
+    if constexpr(std::is_same_v<Value, Decimal>) {
+      return a.differenceOverflows(b);
+    } else {
+      return ((a ^ b) & (a ^ r)) < 0; // NOLINT(hicpp-signed-bitwise)
+    }
+  }
+  template <typename Value> static BOSS_KERNEL_INLINE bool undefined(Value /*a*/, Value /*b*/) {
+    return false;
+  }
+};
+struct Times {
+  template <typename Value> static BOSS_KERNEL_INLINE Value apply(Value a, Value b) {
+    if constexpr(std::is_integral_v<Value>) {
+      return static_cast<Value>(static_cast<Unsigned<Value>>(a) * static_cast<Unsigned<Value>>(b));
+    } else {
+      return a * b;
+    }
+  }
+  template <typename Value>
+  static BOSS_KERNEL_INLINE bool overflows(Value a, Value b, [[maybe_unused]] Value r) {
+    if constexpr(std::is_same_v<Value, Decimal>) {
+      return a.productOverflows(b);
+    } else {
+#if defined(__GNUC__) || defined(__clang__)
+      auto product = Value();
+      return __builtin_mul_overflow(a, b, &product);
+#else
+      return a != 0 && ((a == -1 && b == std::numeric_limits<Value>::min()) || r / a != b);
+#endif
+    }
+  }
+  template <typename Value> static BOSS_KERNEL_INLINE bool undefined(Value /*a*/, Value /*b*/) {
+    return false;
+  }
+};
+/**
+ * Integer division truncates (as in C++); division by zero is an error for integers (the results
+ * of the elements that divide by zero are left at zero, see divide) and infinite for floats
+ */
+struct Divide {
+  template <typename Value> static BOSS_KERNEL_INLINE Value apply(Value a, Value b) {
+    if constexpr(std::is_integral_v<Value>) { // no trap for x / 0 and min / -1
+      return b == 0    ? Value(0)
+             : b == -1 ? static_cast<Value>(Unsigned<Value>(0) - static_cast<Unsigned<Value>>(a))
+                       : a / b;
+    } else {
+      return a / b;
+    }
+  }
+  template <typename Value>
+  static BOSS_KERNEL_INLINE bool overflows(Value a, Value b, Value /*r*/) {
+    return b == -1 && a == std::numeric_limits<Value>::min();
+  }
+  template <typename Value> static BOSS_KERNEL_INLINE bool undefined(Value /*a*/, Value b) {
+    if constexpr(std::is_integral_v<Value>) {
+      return b == 0;
+    } else {
+      return false;
+    }
+  }
+};
+
+/**
+ * The operands of the arithmetic kernels: a column (a numeric span) or a constant, which the
+ * kernels index alike (so that a constant is broadcast to every element)
+ */
+template <typename Value> struct ColumnOperand {
+  Value const* values;
+  size_t size;
+  ValidityBitmap validity;
+  BOSS_KERNEL_INLINE Value operator[](size_t index) const {
+    return values[index]; // NOLINT(*-pointer-arithmetic)
+  }
+};
+template <typename Value> struct ConstantOperand {
+  Value value;
+  ValidityBitmap validity; // always absent: constants are never missing
+  BOSS_KERNEL_INLINE Value operator[](size_t /*index*/) const { return value; }
+};
+template <typename Scalar>
+ColumnOperand<std::remove_const_t<Scalar>> operand(Span<Scalar> const& column) {
+  static_assert(isNumeric<std::remove_const_t<Scalar>> ||
+                    std::is_same_v<std::remove_const_t<Scalar>, Decimal>,
+                "arithmetic expects numeric or decimal columns");
+  return {column.begin(), column.size(), column.getValidity()};
+}
+template <typename Value> ConstantOperand<Value> operand(Value constant) {
+  static_assert(isNumeric<Value> || std::is_same_v<Value, Decimal>,
+                "arithmetic expects numeric or decimal constants");
+  return {constant, {}};
+}
+template <typename Operand> constexpr bool isColumn = false;
+template <typename Value> constexpr bool isColumn<ColumnOperand<Value>> = true;
+
+/**
+ * Applies the operation to the (promoted) elements of the operands, a plain loop that vectorizes.
+ * Returns whether any element's operation is undefined (see Divide) or overflows (if it is
+ * checked), including missing elements (whose values are unspecified), see arithmetic
+ */
+template <typename Operation, bool Checked, typename Result, typename Left, typename Right>
+BOSS_KERNEL_INLINE bool arithmetic(Result* results, Left const& left, Right const& right,
+                                   size_t size) {
+  auto failed = false;
+  for(auto i = size_t(0); i < size; i++) {
+    auto const a = Result(left[i]);
+    auto const b = Result(right[i]);
+    auto const result = Operation::apply(a, b);
+    if constexpr(isExact<Result>) {
+      failed |= Operation::undefined(a, b);
+      if constexpr(Checked) {
+        failed |= Operation::overflows(a, b, result);
+      }
+    }
+    results[i] = result; // NOLINT(*-pointer-arithmetic)
+  }
+  return failed;
+}
+
+#ifdef BOSS_X86_KERNELS
+template <typename Operation, bool Checked, typename Result, typename Left, typename Right>
+BOSS_KERNEL_TARGET("avx512f,avx512bw,avx512dq,avx512vl")
+bool arithmeticAVX512(Result* results, Left const& left, Right const& right, size_t size) {
+  return arithmetic<Operation, Checked>(results, left, right, size);
+}
+template <typename Operation, bool Checked, typename Result, typename Left, typename Right>
+BOSS_KERNEL_TARGET("avx2")
+bool arithmeticAVX2(Result* results, Left const& left, Right const& right, size_t size) {
+  return arithmetic<Operation, Checked>(results, left, right, size);
+}
+#endif
+
+template <typename Operation, bool Checked, typename Result, typename Left, typename Right>
+bool dispatchArithmetic(InstructionSet instructionSet, Result* results, Left const& left,
+                        Right const& right, size_t size) {
+  switch(instructionSet) {
+#ifdef BOSS_X86_KERNELS
+  case InstructionSet::AVX512:
+    return arithmeticAVX512<Operation, Checked>(results, left, right, size);
+  case InstructionSet::AVX2:
+    return arithmeticAVX2<Operation, Checked>(results, left, right, size);
+#endif
+  default:
+    return arithmetic<Operation, Checked>(results, left, right, size);
+  }
+}
+
+/**
+ * Evaluates the operation element-wise into the output (which must have the operands' size and
+ * the promoted type) and gives it the intersection of the operands' validity. If the kernel
+ * reports a failure, the valid elements are checked again one by one (so that missing elements
+ * cannot fail) to throw std::domain_error (integer division by zero) or std::overflow_error
+ */
+template <typename Operation, typename Left, typename Right, typename OutputScalar>
+void arithmetic(Left const& left, Right const& right, Span<OutputScalar>& output,
+                IntegerOverflow overflow, InstructionSet instructionSet) {
+  using LeftValue = std::decay_t<decltype(left[0])>;
+  using RightValue = std::decay_t<decltype(right[0])>;
+  using Result = Promoted<LeftValue, RightValue>;
+  static_assert(std::is_same_v<OutputScalar, Result>,
+                "the output must have the promoted type of the operands (see Promoted)");
+  static_assert(std::is_same_v<LeftValue, RightValue> || !std::is_same_v<Result, Decimal>,
+                "decimals can only be combined with decimals");
+  static_assert(!std::is_same_v<Operation, Divide> || !std::is_same_v<Result, Decimal>,
+                "decimals cannot be divided (the quotient is not exact)");
+  if(!isSupported(instructionSet)) {
+    throw std::invalid_argument("the processor does not support the requested instruction set");
+  }
+  auto size = output.size();
+  if constexpr(isColumn<Left>) {
+    size = left.size;
+  } else if constexpr(isColumn<Right>) {
+    size = right.size;
+  }
+  if constexpr(isColumn<Left> && isColumn<Right>) {
+    if(left.size != right.size) {
+      throw std::invalid_argument("cannot combine columns of sizes " + std::to_string(left.size) +
+                                  " and " + std::to_string(right.size));
+    }
+  }
+  if(output.size() != size) {
+    throw std::invalid_argument("cannot write a column of size " + std::to_string(size) +
+                                " into one of size " + std::to_string(output.size()));
+  }
+  auto const validity = left.validity & right.validity;
+  if(size > 0) {
+    auto* results = output.mutableBegin();
+    auto const checked = overflow == IntegerOverflow::Check && // 32-bit operands cannot overflow
+                         (sizeof(LeftValue) == sizeof(Result) ||
+                          sizeof(RightValue) == sizeof(Result));
+    auto const failed =
+        checked ? dispatchArithmetic<Operation, true>(instructionSet, results, left, right, size)
+                : dispatchArithmetic<Operation, false>(instructionSet, results, left, right, size);
+    for(auto i = size_t(0); failed && i < size; i++) {
+      if constexpr(isExact<Result>) {
+        auto const a = Result(left[i]);
+        auto const b = Result(right[i]);
+        if(!validity.isValid(i)) {
+          continue;
+        }
+        if(Operation::undefined(a, b)) {
+          throw std::domain_error("integer division by zero");
+        }
+        if(checked && Operation::overflows(a, b, Operation::apply(a, b))) {
+          throw std::overflow_error("the result of the integer arithmetic does not fit 64 bits");
+        }
+      }
+    }
+  }
+  output = std::move(output).withValidity(validity);
+}
+} // namespace kernels
+
+/**
+ * Element-wise arithmetic for projections, e.g., plus(prices, taxes, output) or minus(1,
+ * discounts, output): each operand is a numeric span (of 32 or 64-bit integers or floats) or a
+ * constant, and the result goes into a preallocated output span of the operands' size and
+ * promoted type (see Promoted). Missing elements of either operand are missing in the output.
+ * Integer results wrap around unless overflow is IntegerOverflow::Check (see IntegerOverflow).
+ * Decimals combine with decimals (spans or constants) only, in integer loops over the unscaled
+ * values (see Decimal for the rounding of products), and overflow like integers
+ */
+template <typename Left, typename Right, typename OutputScalar>
+void plus(Left const& left, Right const& right, Span<OutputScalar>& output,
+          IntegerOverflow overflow = IntegerOverflow::Wrap,
+          InstructionSet instructionSet = supportedInstructionSet()) {
+  kernels::arithmetic<kernels::Plus>(kernels::operand(left), kernels::operand(right), output,
+                                     overflow, instructionSet);
+}
+template <typename Left, typename Right, typename OutputScalar>
+void minus(Left const& left, Right const& right, Span<OutputScalar>& output,
+           IntegerOverflow overflow = IntegerOverflow::Wrap,
+           InstructionSet instructionSet = supportedInstructionSet()) {
+  kernels::arithmetic<kernels::Minus>(kernels::operand(left), kernels::operand(right), output,
+                                      overflow, instructionSet);
+}
+template <typename Left, typename Right, typename OutputScalar>
+void times(Left const& left, Right const& right, Span<OutputScalar>& output,
+           IntegerOverflow overflow = IntegerOverflow::Wrap,
+           InstructionSet instructionSet = supportedInstructionSet()) {
+  kernels::arithmetic<kernels::Times>(kernels::operand(left), kernels::operand(right), output,
+                                      overflow, instructionSet);
+}
+/**
+ * see plus: integer division truncates and throws std::domain_error if a (valid) divisor is zero.
+ * Decimals cannot be divided
+ */
+template <typename Left, typename Right, typename OutputScalar>
+void divide(Left const& left, Right const& right, Span<OutputScalar>& output,
+            IntegerOverflow overflow = IntegerOverflow::Wrap,
+            InstructionSet instructionSet = supportedInstructionSet()) {
+  kernels::arithmetic<kernels::Divide>(kernels::operand(left), kernels::operand(right), output,
+                                       overflow, instructionSet);
+}
+
+namespace kernels {
+constexpr auto hashSeed = std::uint64_t(0x243f6a8885a308d3ULL);       // the digits of pi
+constexpr auto hashMultiplier = std::uint64_t(0x9e3779b97f4a7c15ULL); // 2^64 / the golden ratio
+constexpr auto nullKey = std::uint64_t(0x13198a2e03707344ULL);         // the key of missing values
+
+/**
+ * The finalizer of MurmurHash3: every bit of the input affects every bit of the output (in
+ * particular the high bits, which radix partitioning takes)
+ */
+BOSS_KERNEL_INLINE std::uint64_t mix(std::uint64_t hash) {
+  constexpr auto first = std::uint64_t(0xff51afd7ed558ccdULL);
+  constexpr auto second = std::uint64_t(0xc4ceb9fe1a85ec53ULL);
+  hash ^= hash >> 33U;
+  hash *= first;
+  hash ^= hash >> 33U;
+  hash *= second;
+  return hash ^ (hash >> 33U);
+}
+/**
+ * folds the key of the next column into the hash of a row (so that the order of the columns
+ * matters)
+ */
+BOSS_KERNEL_INLINE std::uint64_t combineKey(std::uint64_t hash, std::uint64_t key) {
+  return mix(hash * hashMultiplier + key);
+}
+
+/**
+ * The key of a string: its bytes, eight at a time (and the rest zero-padded), multiplied into a
+ * running hash, which is mixed with the size at the end
+ */
+inline std::uint64_t hashBytes(std::string_view bytes) {
+  constexpr auto wordSize = sizeof(std::uint64_t);
+  constexpr auto rotation = 31U;
+  auto hash = hashSeed;
+  auto i = size_t(0);
+  auto const step = [&hash](std::uint64_t word) {
+    word *= hashMultiplier;
+    hash = ((hash ^ word) << rotation | (hash ^ word) >> (64U - rotation)) * hashMultiplier;
+  };
+  for(; i + wordSize <= bytes.size(); i += wordSize) {
+    auto word = std::uint64_t(0);
+    std::memcpy(&word, bytes.data() + i, wordSize); // NOLINT(*-pointer-arithmetic)
+    step(word);
+  }
+  if(i < bytes.size()) {
+    auto word = std::uint64_t(0);
+    std::memcpy(&word, bytes.data() + i, bytes.size() - i); // NOLINT(*-pointer-arithmetic)
+    step(word);
+  }
+  return mix(hash ^ bytes.size());
+}
+
+/**
+ * The key columns of the hash kernels, which give every element a 64-bit key: integers (of either
+ * width) as 64-bit integers, floats (of either width) with integral values (in the range of 64-bit
+ * integers, including -0) as those integers and other floats as the bits of the double (so that
+ * equal numbers have equal keys, whatever the types of their columns), and strings as hashBytes
+ * of their bytes
+ */
+template <typename Value> struct NumericKeys {
+  Value const* values;
+  size_t size;
+  ValidityBitmap validity;
+  BOSS_KERNEL_INLINE std::uint64_t key(size_t index) const {
+    if constexpr(std::is_integral_v<Value>) {
+      return static_cast<std::uint64_t>(std::int64_t(values[index])); // NOLINT
+    } else {
+      constexpr auto twoToThe63 = 9223372036854775808.0;
+      auto const value = std::double_t(values[index]); // NOLINT(*-pointer-arithmetic)
+      if(value >= -twoToThe63 && value < twoToThe63) { // false for NaNs
+        auto const integer = static_cast<std::int64_t>(value);
+        if(std::double_t(integer) == value) {
+          return static_cast<std::uint64_t>(integer);
+        }
+      }
+      auto bits = std::uint64_t(0);
+      std::memcpy(&bits, &value, sizeof(bits));
+      return bits;
+    }
+  }
+};
+template <typename Column> struct StringKeys {
+  Column const* column;
+  size_t size;
+  ValidityBitmap validity;
+  std::uint64_t key(size_t index) const { return hashBytes((*column)[index]); }
+};
+/**
+ * the keys of a dictionary-encoded column are those of its dictionary's values, which are hashed
+ * once (so the keys of the elements are gathered by code)
+ */
+struct DictionaryKeys {
+  Span<DictionaryEncoded>::Code const* codes;
+  size_t size;
+  ValidityBitmap validity;
+  std::vector<std::uint64_t> dictionary;
+  BOSS_KERNEL_INLINE std::uint64_t key(size_t index) const {
+    return dictionary[codes[index]]; // NOLINT(*-pointer-arithmetic)
+  }
+};
+
+template <typename Scalar> auto keys(Span<Scalar> const& column) {
+  using Value = std::remove_const_t<Scalar>;
+  if constexpr(std::is_same_v<Value, std::string>) {
+    return StringKeys<Span<Scalar>>{&column, column.size(), column.getValidity()};
+  } else {
+    static_assert(isNumeric<Value>, "the hash kernels expect numeric or string columns");
+    return NumericKeys<Value>{column.begin(), column.size(), column.getValidity()};
+  }
+}
+inline auto keys(Span<std::string_view> const& column) {
+  return StringKeys<Span<std::string_view>>{&column, column.size(), column.getValidity()};
+}
+inline auto keys(Span<DictionaryEncoded> const& column) {
+  auto const& values = column.getDictionary();
+  auto dictionary = std::vector<std::uint64_t>(values.size());
+  std::transform(values.begin(), values.end(), dictionary.begin(), hashBytes);
+  return DictionaryKeys{column.codeData(), column.size(), column.getValidity(),
+                        std::move(dictionary)};
+}
+
+/**
+ * Folds the keys of the rows [first, first + count) into their hashes, a block of 64 (i.e., a
+ * validity word) at a time: missing elements have the nullKey (so that they hash alike, as SQL
+ * groups them). first must be a multiple of 64
+ */
+template <typename Keys>
+BOSS_KERNEL_INLINE void combineKeys(std::uint64_t* hashes, Keys const& keys, size_t first,
+                                    size_t count) {
+  constexpr auto blockSize = Bitmap::bitsPerWord;
+  for(auto begin = first; begin < first + count; begin += blockSize) {
+    auto const end = std::min(begin + blockSize, first + count);
+    auto const valid = validWord(keys.validity, begin / blockSize);
+    if(valid == ~Bitmap::Word(0)) {
+      for(auto i = begin; i < end; i++) {
+        hashes[i] = combineKey(hashes[i], keys.key(i)); // NOLINT(*-pointer-arithmetic)
+      }
+    } else {
+      for(auto i = begin; i < end; i++) {
+        hashes[i] = combineKey(hashes[i], // NOLINT(*-pointer-arithmetic)
+                               (valid >> (i - begin) & 1U) != 0 ? keys.key(i) : nullKey);
+      }
+    }
+  }
+}
+
+/**
+ * Hashes the rows a chunk at a time, folding all key columns into a chunk of hashes while it is in
+ * the L1 cache (so the hashes are written once). Unless the hashes are extended, they start from
+ * the seed
+ */
+template <bool Extend, typename... Keys>
+BOSS_KERNEL_INLINE void hashRows(std::uint64_t* hashes, size_t size, Keys const&... keys) {
+  constexpr auto chunkSize = size_t(1024);
+  for(auto first = size_t(0); first < size; first += chunkSize) {
+    auto const count = std::min(chunkSize, size - first);
+    if constexpr(!Extend) {
+      std::fill_n(hashes + first, count, hashSeed); // NOLINT(*-pointer-arithmetic)
+    }
+    (combineKeys(hashes, keys, first, count), ...);
+  }
+}
+
+#ifdef BOSS_X86_KERNELS
+template <bool Extend, typename... Keys>
+BOSS_KERNEL_TARGET("avx512f,avx512bw,avx512dq,avx512vl")
+void hashRowsAVX512(std::uint64_t* hashes, size_t size, Keys const&... keys) {
+  hashRows<Extend>(hashes, size, keys...);
+}
+template <bool Extend, typename... Keys>
+BOSS_KERNEL_TARGET("avx2")
+void hashRowsAVX2(std::uint64_t* hashes, size_t size, Keys const&... keys) {
+  hashRows<Extend>(hashes, size, keys...);
+}
+#endif
+
+template <bool Extend, typename... Keys>
+void dispatchHashRows(InstructionSet instructionSet, Span<std::uint64_t>& hashes,
+                      Keys const&... keys) {
+  if(!isSupported(instructionSet)) {
+    throw std::invalid_argument("the processor does not support the requested instruction set");
+  }
+  if(((keys.size != hashes.size()) || ...)) {
+    throw std::invalid_argument("cannot hash columns of sizes other than " +
+                                std::to_string(hashes.size()));
+  }
+  if(hashes.size() == 0) {
+    return;
+  }
+  auto* results = hashes.mutableBegin();
+  switch(instructionSet) {
+#ifdef BOSS_X86_KERNELS
+  case InstructionSet::AVX512:
+    hashRowsAVX512<Extend>(results, hashes.size(), keys...);
+    return;
+  case InstructionSet::AVX2:
+    hashRowsAVX2<Extend>(results, hashes.size(), keys...);
+    return;
+#endif
+  default:
+    hashRows<Extend>(results, hashes.size(), keys...);
+  }
+}
+} // namespace kernels
+
+/**
+ * The hashes of the rows of one or more key columns (of the same size), e.g., to join on
+ * "Equal"_("L_ORDERKEY"_, "O_ORDERKEY"_) or to group by several columns: one 64-bit hash per row,
+ * written in a single pass over the columns. The columns may be numeric spans (equal numbers hash
+ * alike whatever the types of their columns, e.g., the int64_t 1 and the double 1.0, see
+ * NumericKeys) or string spans (std::string, std::string_view or dictionary-encoded, which hash
+ * alike); missing elements hash alike, too. Every bit of a hash
+ * depends on every key, so radix partitioning can take the high bits (hash >> (64 - bits)). The
+ * hashes are stable within a process, not a persistent format
+ */
+template <typename Column, typename... Columns>
+Span<std::uint64_t> hash(InstructionSet instructionSet, Column const& column,
+                         Columns const&... columns) {
+  auto hashes = Span<std::uint64_t>(std::vector<std::uint64_t>(column.size()));
+  kernels::dispatchHashRows<false>(instructionSet, hashes, kernels::keys(column),
+                                   kernels::keys(columns)...);
+  return hashes;
+}
+template <typename Column, typename... Columns>
+std::enable_if_t<!std::is_same_v<Column, InstructionSet>, Span<std::uint64_t>>
+hash(Column const& column, Columns const&... columns) {
+  return hash(supportedInstructionSet(), column, columns...);
+}
+
+/**
+ * Extends the (preallocated) hashes of rows with more key columns, so that hash(a, b) is the same
+ * as hash(a) extended with b, e.g., for engines that get the key columns one at a time, see hash
+ */
+template <typename... Columns>
+void extendHash(InstructionSet instructionSet, Span<std::uint64_t>& hashes,
+                Columns const&... columns) {
+  kernels::dispatchHashRows<true>(instructionSet, hashes, kernels::keys(columns)...);
+}
+template <typename... Columns>
+void extendHash(Span<std::uint64_t>& hashes, Columns const&... columns) {
+  extendHash(supportedInstructionSet(), hashes, columns...);
+}
+
+/**
+ * The exact sum of the valid elements of a span of decimals, which is the exact (wide) sum of their
+ * unscaled values (see kernels::WideSum), so it cannot drift or overflow on the way. Throws
+ * std::overflow_error if the result does not fit a Decimal
+ */
+template <typename Scalar>
+std::enable_if_t<std::is_same_v<std::remove_const_t<Scalar>, Decimal>, Decimal>
+sum(Span<Scalar> const& decimals, InstructionSet instructionSet = supportedInstructionSet()) {
+  auto const wide = kernels::dispatchWideSum(decimals.begin(), decimals.size(),
+                                             decimals.getValidity(), instructionSet);
+  if(!wide.fitsInt64()) {
+    throw std::overflow_error("the sum of the decimals does not fit a Decimal");
+  }
+  return Decimal::fromUnscaledValue(wide.toInt64());
+}
+
 } // namespace boss::algorithm
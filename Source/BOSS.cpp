@@ -59,6 +59,13 @@ BOSSExpression* stringToNewBOSSExpression(char const* string) {
 BOSSExpression* bossSymbolNameToNewBOSSExpression(char const* name) {
   return new BOSSExpression{boss::Expression(boss::Symbol(name))};
 }
+BOSSExpression* dateToNewBOSSExpression(int32_t daysSinceEpoch) {
+  return new BOSSExpression{boss::Expression(boss::expressions::Date(daysSinceEpoch))};
+}
+BOSSExpression* decimalToNewBOSSExpression(int64_t unscaledValue) {
+  return new BOSSExpression{
+      boss::Expression(boss::expressions::Decimal::fromUnscaledValue(unscaledValue))};
+}
 
 BOSSSymbol* symbolNameToNewBOSSSymbol(char const* name) {
   return new BOSSSymbol{boss::Symbol(name)};
@@ -67,6 +74,7 @@ BOSSSymbol* symbolNameToNewBOSSSymbol(char const* name) {
 BOSSExpression* newComplexBOSSExpression(BOSSSymbol* head, size_t cardinality,
                                          BOSSExpression* arguments[]) {
   auto args = boss::ExpressionArguments();
+  args.reserve(cardinality);
   ::std::transform(arguments, arguments + cardinality, ::std::back_insert_iterator(args),
                    [](auto const* a) {
                      return a->delegate.clone(CloneReason::CONVERSION_TO_C_BOSS_EXPRESSION);
@@ -82,7 +90,7 @@ char const* bossSymbolToNewString(BOSSSymbol const* arg) {
 
 /**
  *  bool = 0, char = 1, int = 2, long = 3, float = 4, double = 5, std::string = 6, Symbol = 7,
- *  ComplexExpression = 8
+ *  Date = 8, Decimal = 9, ComplexExpression = 10
  */
 
 size_t getBOSSExpressionTypeID(BOSSExpression const* arg) {
@@ -111,8 +119,14 @@ size_t getBOSSExpressionTypeID(BOSSExpression const* arg) {
       ::std::is_same_v<boss::Symbol,
                        ::std::variant_alternative_t<7, boss::Expression::SuperType>>); // NOLINT
   static_assert(
-      ::std::is_same_v<boss::ComplexExpression,
+      ::std::is_same_v<boss::expressions::Date,
                        ::std::variant_alternative_t<8, boss::Expression::SuperType>>); // NOLINT
+  static_assert(
+      ::std::is_same_v<boss::expressions::Decimal,
+                       ::std::variant_alternative_t<9, boss::Expression::SuperType>>); // NOLINT
+  static_assert(
+      ::std::is_same_v<boss::ComplexExpression,
+                       ::std::variant_alternative_t<10, boss::Expression::SuperType>>); // NOLINT
   return arg->delegate.index();
 }
 
@@ -138,6 +152,12 @@ char* getNewStringValueFromBOSSExpression(BOSSExpression const* arg) {
 char const* getNewSymbolNameFromBOSSExpression(BOSSExpression const* arg) {
   return strdup(get<boss::Symbol>(arg->delegate).getName().c_str());
 }
+std::int32_t getDateValueFromBOSSExpression(BOSSExpression const* arg) {
+  return get<boss::expressions::Date>(arg->delegate).getDaysSinceEpoch();
+}
+std::int64_t getDecimalValueFromBOSSExpression(BOSSExpression const* arg) {
+  return get<boss::expressions::Decimal>(arg->delegate).getUnscaledValue();
+}
 
 BOSSSymbol* getHeadFromBOSSExpression(BOSSExpression const* arg) {
   return new BOSSSymbol{get<boss::ComplexExpression>(arg->delegate).getHead()};
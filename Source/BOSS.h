@@ -22,13 +22,21 @@ struct BOSSExpression* floatToNewBOSSExpression(float value);
 struct BOSSExpression* doubleToNewBOSSExpression(double value);
 struct BOSSExpression* stringToNewBOSSExpression(char const* string);
 struct BOSSExpression* symbolNameToNewBOSSExpression(char const* name);
+/**
+ * dates are passed as the number of days since 1970-01-01
+ */
+struct BOSSExpression* dateToNewBOSSExpression(int32_t daysSinceEpoch);
+/**
+ * decimals are passed as their unscaled value, i.e., the number of 0.0001 units
+ */
+struct BOSSExpression* decimalToNewBOSSExpression(int64_t unscaledValue);
 
 struct BOSSExpression* newComplexBOSSExpression(struct BOSSSymbol* head, size_t cardinality,
                                                 struct BOSSExpression* arguments[]);
 
 /**
  *  bool = 0, char = 1, int = 2, long = 3, float = 4, double = 5, std::string = 6, Symbol = 7,
- *  ComplexExpression = 8
+ *  Date = 8, Decimal = 9, ComplexExpression = 10
  */
 size_t getBOSSExpressionTypeID(struct BOSSExpression const* arg);
 
@@ -40,6 +48,8 @@ float getFloatValueFromBOSSExpression(struct BOSSExpression const* arg);
 double getDoubleValueFromBOSSExpression(struct BOSSExpression const* arg);
 char* getNewStringValueFromBOSSExpression(struct BOSSExpression const* arg);
 char const* getNewSymbolNameFromBOSSExpression(struct BOSSExpression const* arg);
+int32_t getDateValueFromBOSSExpression(struct BOSSExpression const* arg);
+int64_t getDecimalValueFromBOSSExpression(struct BOSSExpression const* arg);
 
 struct BOSSSymbol* getHeadFromBOSSExpression(struct BOSSExpression const* arg);
 size_t getArgumentCountFromBOSSExpression(struct BOSSExpression const* arg);
@@ -54,6 +54,7 @@ static void* dlsym(void* hModule, LPCSTR lpProcName) {
 
 #include <algorithm>
 #include <iterator>
+#include <memory_resource>
 #include <numeric>
 #include <optional>
 #include <stdexcept>
@@ -112,6 +113,13 @@ class BootstrapEngine : public boss::Engine {
 
   ::std::vector<::std::string> defaultEngine = {};
 
+  /**
+   * When set, every root expression is evaluated with a monotonic arena as the expression memory
+   * resource and only the result is relocated out of it. This is only safe if no engine in the
+   * pipeline retains expressions (or parts of them) across evaluations.
+   */
+  bool useExpressionArena = false;
+
   ::std::unordered_map<boss::Symbol,
                        ::std::function<boss::Expression(boss::ComplexExpression&&)>> const
       registeredOperators{
@@ -161,6 +169,10 @@ class BootstrapEngine : public boss::Engine {
           {boss::Symbol("ResetEngines"), [this](auto&& /*expression*/) -> boss::Expression {
              libraries.clear();
              return "okay";
+           }},
+          {boss::Symbol("UseExpressionArena"), [this](auto&& expression) -> boss::Expression {
+             useExpressionArena = get<bool>(expression.getArguments().at(0));
+             return "okay";
            }}};
   bool isBootstrapCommand(boss::Expression const& expression) {
     return visit(utilities::overload(
@@ -190,6 +202,19 @@ public:
 
   // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
   boss::Expression evaluate(boss::Expression&& e, bool isRootExpression = true) {
+    if(isRootExpression && useExpressionArena && !isBootstrapCommand(e)) {
+      auto arena = ::std::pmr::monotonic_buffer_resource();
+      auto result = [this, &arena, &e] {
+        auto const scope = expressions::ScopedExpressionMemoryResource(&arena);
+        return evaluateWithoutArena(::std::move(e), true);
+      }();
+      return ::std::move(result).relocate(); // the arena is released in one go afterwards
+    }
+    return evaluateWithoutArena(::std::move(e), isRootExpression);
+  }
+
+private:
+  boss::Expression evaluateWithoutArena(boss::Expression&& e, bool isRootExpression) {
     using boss::utilities::operator""_;
 
     auto wrappedE =
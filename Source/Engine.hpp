@@ -1,11 +1,171 @@
 #pragma once
 #include "Expression.hpp"
+#include <cstddef>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
 namespace boss {
 namespace engines {
 class Engine {
 public:
   expressions::Expression evaluate(expressions::Expression const&);
 };
+
+/**
+ * A base for engines that interpret expressions operator by operator. Derived engines register
+ * their operators (member functions) by head symbol, usually in their constructor:
+ *
+ *   class Calculator : public EngineBase<Calculator> {
+ *   public:
+ *     Calculator() { registerOperator<&Calculator::plus>(Symbol("Plus")); }
+ *     Expression plus(ComplexExpressionWithStaticArguments<std::int64_t, std::int64_t>&& e) {
+ *       return std::get<0>(e.getStaticArguments()) + std::get<1>(e.getStaticArguments());
+ *     }
+ *   };
+ *
+ * The parameter type of an operator is its argument shape: a ComplexExpressionWithStaticArguments
+ * matches expressions with exactly these argument types (which are moved into its static
+ * arguments), a ComplexExpression matches any arguments. Operators registered for the same head are
+ * tried in the order of registration. evaluate() evaluates the arguments of complex expressions
+ * bottom-up before dispatching on the head. The dispatch table is indexed by (interned) symbol IDs,
+ * so finding the operators of a head is an array lookup rather than a string comparison per
+ * operator, and matching a shape only compares variant indices. Expressions that no operator
+ * matches are passed to the derived engine's unknownOperator (which returns them as they are,
+ * unless the derived engine hides it).
+ */
+template <typename Derived> class EngineBase : public Engine {
+public:
+  using Expression = expressions::Expression;
+  using ComplexExpression = expressions::ComplexExpression;
+
+private:
+  /**
+   * operators are matched against (and handed) the parts of evaluated expressions, so only
+   * operators that take a ComplexExpression need one to be put back together
+   */
+  struct Overload {
+    bool (*matches)(expressions::ExpressionArguments const&,
+                    expressions::ExpressionSpanArguments const&);
+    Expression (*handle)(Derived&, Symbol&&, expressions::ExpressionArguments&&,
+                         expressions::ExpressionSpanArguments&&);
+  };
+  struct Operators {
+    std::optional<Symbol> head; // empty for the IDs of symbols that have no operators
+    std::vector<Overload> overloads;
+  };
+  std::vector<Operators> dispatchTable; // indexed by symbol ID
+  /**
+   * for heads from another symbol table (see Symbol), whose IDs do not index the dispatch table
+   */
+  std::unordered_map<Symbol, size_t> dispatchTableIndex;
+
+  template <typename Parameter> struct Shape;
+  /**
+   * a ComplexExpression (i.e., one without static arguments) matches any arguments
+   */
+  template <typename... ArgumentTypes>
+  struct Shape<expressions::ComplexExpressionWithStaticArguments<ArgumentTypes...>> {
+    static bool matches(expressions::ExpressionArguments const& arguments,
+                        expressions::ExpressionSpanArguments const& spanArguments) {
+      if constexpr(sizeof...(ArgumentTypes) == 0) {
+        return true;
+      } else {
+        return arguments.size() == sizeof...(ArgumentTypes) && spanArguments.empty() &&
+               matchesTypes(arguments, std::index_sequence_for<ArgumentTypes...>());
+      }
+    }
+    template <auto Operator>
+    static Expression handle(Derived& engine, Symbol&& head,
+                             expressions::ExpressionArguments&& arguments,
+                             expressions::ExpressionSpanArguments&& spanArguments) {
+      if constexpr(sizeof...(ArgumentTypes) == 0) {
+        return (engine.*Operator)(
+            ComplexExpression(std::move(head), {}, std::move(arguments), std::move(spanArguments)));
+      } else {
+        return (engine.*Operator)(toStaticArguments(std::move(head), std::move(arguments),
+                                                    std::index_sequence_for<ArgumentTypes...>()));
+      }
+    }
+
+  private:
+    template <size_t... I>
+    static bool matchesTypes(expressions::ExpressionArguments const& arguments,
+                             std::index_sequence<I...> /*unused*/) {
+      return (std::holds_alternative<ArgumentTypes>(arguments[I]) && ...);
+    }
+    template <size_t... I>
+    static expressions::ComplexExpressionWithStaticArguments<ArgumentTypes...>
+    toStaticArguments(Symbol&& head, expressions::ExpressionArguments&& arguments,
+                      std::index_sequence<I...> /*unused*/) {
+      return {std::move(head),
+              std::tuple<ArgumentTypes...>(std::get<ArgumentTypes>(std::move(arguments[I]))...)};
+    }
+  };
+  template <typename Parameter>
+  static Parameter parameterOf(Expression (Derived::*)(Parameter&&)); // NOLINT
+
+  Derived& derived() { return static_cast<Derived&>(*this); }
+
+  Operators const* find(Symbol const& head) const {
+    if(auto const id = head.getID(); id < dispatchTable.size() && dispatchTable[id].head &&
+                                     *dispatchTable[id].head == head) {
+      return &dispatchTable[id];
+    }
+    if(auto it = dispatchTableIndex.find(head); it != dispatchTableIndex.end()) {
+      return &dispatchTable[it->second];
+    }
+    return nullptr;
+  }
+
+protected:
+  /**
+   * registers the member function Operator (see the class comment for the argument shapes)
+   */
+  template <auto Operator> void registerOperator(Symbol const& head) {
+    using Parameter = decltype(parameterOf(Operator));
+    if(head.getID() >= dispatchTable.size()) {
+      dispatchTable.resize(head.getID() + 1);
+    }
+    auto& operators = dispatchTable[head.getID()];
+    operators.head = head;
+    operators.overloads.push_back(
+        {&Shape<Parameter>::matches, &Shape<Parameter>::template handle<Operator>});
+    dispatchTableIndex.emplace(head, head.getID());
+  }
+
+  Expression evaluateComplex(ComplexExpression&& e) {
+    auto [head, unused, arguments, spanArguments] = std::move(e).decompose();
+    for(auto& argument : arguments) {
+      if(std::holds_alternative<ComplexExpression>(argument)) {
+        argument = evaluateComplex(std::get<ComplexExpression>(std::move(argument)));
+      }
+    }
+    if(auto const* operators = find(head)) {
+      for(auto const& overload : operators->overloads) {
+        if(overload.matches(arguments, spanArguments)) {
+          return overload.handle(derived(), std::move(head), std::move(arguments),
+                                 std::move(spanArguments));
+        }
+      }
+    }
+    return derived().unknownOperator(
+        ComplexExpression(std::move(head), {}, std::move(arguments), std::move(spanArguments)));
+  }
+
+public:
+  Expression evaluate(Expression&& e) {
+    if(!std::holds_alternative<ComplexExpression>(e)) {
+      return std::move(e);
+    }
+    return evaluateComplex(std::get<ComplexExpression>(std::move(e)));
+  }
+
+  Expression unknownOperator(ComplexExpression&& e) { return std::move(e); }
+};
 } // namespace engines
-using boss::engines::Engine; // NOLINT(misc-unused-using-decls)
+using boss::engines::Engine;     // NOLINT(misc-unused-using-decls)
+using boss::engines::EngineBase; // NOLINT(misc-unused-using-decls)
 } // namespace boss
@@ -1,18 +1,33 @@
 #pragma once
+#include "ExpressionAllocator.hpp"
 #include "Utilities.hpp"
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <climits>
 #include <cmath>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <optional>
+#include <shared_mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
 #include <typeindex>
+#include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -31,6 +46,7 @@ enum class CloneReason {
   EXPRESSION_WRAPPING,       // use expression as argument for another complex expression
   EXPRESSION_SUBSTITUTION,   // modifying arguments (includes argument evaluation)
   EXPRESSION_AUGMENTATION,   // adding new arguments
+  COPY_ON_WRITE,             // modifying the arguments of a shared expression
 };
 static void checkCloneWithoutReason(CloneReason reason) {}
 [[deprecated("Provide a reason type instead")]] static void checkCloneWithoutReason() {}
@@ -38,163 +54,2268 @@ static void checkCloneWithoutReason(CloneReason reason) {}
 namespace atoms {
 // NOLINTBEGIN(bugprone-exception-escape)
 // see https://github.com/llvm/llvm-project/issues/54668
+/**
+ * Symbols are interned in a process-wide table: every distinct name is stored exactly once and a
+ * Symbol is just a pointer to its table entry. This makes comparison a pointer compare and hashing
+ * a load of the precomputed hash. The name is still available (by reference) through getName().
+ *
+ * Engines loaded as shared libraries may end up with their own copy of the table (depending on
+ * symbol visibility), so equality falls back to comparing the (cached) hash and then the name when
+ * the entries differ. IDs are dense and stable for the lifetime of the table they come from.
+ */
 class Symbol {
-  std::string name;
+  struct Entry {
+    std::string name;
+    size_t hash;
+    size_t id;
+  };
+
+  class Table {
+    std::shared_mutex mutex;
+    std::deque<Entry> entries; // deque: entries (and the names the index points into) never move
+    std::unordered_map<std::string_view, Entry const*> index;
+
+  public:
+    Entry const& intern(std::string_view name) {
+      {
+        std::shared_lock lock(mutex);
+        if(auto it = index.find(name); it != index.end()) {
+          return *it->second;
+        }
+      }
+      std::unique_lock lock(mutex);
+      if(auto it = index.find(name); it != index.end()) {
+        return *it->second;
+      }
+      auto const& entry = entries.emplace_back(
+          Entry{std::string(name), std::hash<std::string_view>{}(name), entries.size()});
+      index.emplace(entry.name, &entry);
+      return entry;
+    }
+  };
+
+  static Table& table() {
+    static auto* instance = new Table; // intentionally leaked: Symbols may outlive static dtors
+    return *instance;
+  }
+
+  Entry const* entry;
 
 public:
-  explicit Symbol(std::string name) noexcept : name(std::move(name)){};
-  std::string const& getName() const& { return name; };
-  std::string getName() && { return std::move(name); };
-  inline bool operator==(Symbol const& other) const { return getName() == other.getName(); };
-  inline bool operator!=(Symbol const& other) const { return getName() != other.getName(); };
+  explicit Symbol(std::string_view name) : entry(&table().intern(name)){};
+  explicit Symbol(std::string const& name) : Symbol(std::string_view(name)){};
+  explicit Symbol(char const* name) : Symbol(std::string_view(name)){};
+  std::string const& getName() const { return entry->name; };
+  size_t getID() const { return entry->id; };
+  size_t hash() const { return entry->hash; };
+  inline bool operator==(Symbol const& other) const {
+    return entry == other.entry ||
+           (entry->hash == other.entry->hash && entry->name == other.entry->name);
+  };
+  inline bool operator!=(Symbol const& other) const { return !(*this == other); };
   friend ::std::ostream& operator<<(::std::ostream& out, Symbol const& thing) {
     return out << thing.getName();
   }
 };
 // NOLINTEND(bugprone-exception-escape)
 
-template <typename Scalar> struct Span {
-private: // state
-  using IteratorType = std::conditional_t<
-      std::is_same_v<std::remove_const_t<Scalar>, bool>,
-      std::conditional_t<std::is_const_v<Scalar>, typename std::vector<bool>::const_iterator,
-                         typename std::vector<bool>::iterator>,
-      Scalar*>;
-  IteratorType _begin = {};
-  IteratorType _end = {};
-  std::function<void(void)> destructor;
+// NOLINTBEGIN(*-magic-numbers)
+/**
+ * A calendar date (proleptic Gregorian), stored as the number of days since 1970-01-01. Dates are
+ * plain 32-bit integers in memory, so spans of dates are contiguous and predicates on them are
+ * integer comparisons. They print as the DateObject["yyyy-mm-dd"] expressions they replace.
+ */
+class Date {
+  std::int32_t daysSinceEpoch = 0;
+
+  // see http://howardhinnant.github.io/date_algorithms.html
+  static constexpr std::int32_t daysFromCivil(std::int32_t year, std::uint32_t month,
+                                              std::uint32_t day) {
+    year -= month <= 2 ? 1 : 0;
+    auto const era = (year >= 0 ? year : year - 399) / 400;
+    auto const yearOfEra = static_cast<std::uint32_t>(year - era * 400);
+    auto const dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    auto const dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<std::int32_t>(dayOfEra) - 719468;
+  }
+
+public:
+  struct Civil {
+    std::int32_t year;
+    std::uint32_t month;
+    std::uint32_t day;
+  };
+
+  Date() = default;
+  constexpr explicit Date(std::int32_t daysSinceEpoch) : daysSinceEpoch(daysSinceEpoch) {}
+  constexpr Date(std::int32_t year, std::uint32_t month, std::uint32_t day)
+      : daysSinceEpoch(daysFromCivil(year, month, day)) {}
+  /**
+   * parses an ISO 8601 date (yyyy-mm-dd) and throws std::invalid_argument for anything else
+   * (including dates that do not exist, like 1999-02-29)
+   */
+  explicit Date(std::string_view isoDate) {
+    auto const digits = [&isoDate](size_t begin, size_t end) {
+      auto result = std::uint32_t(0);
+      for(auto i = begin; i < end; i++) {
+        if(isoDate[i] < '0' || isoDate[i] > '9') {
+          throw std::invalid_argument("not a yyyy-mm-dd date: " + std::string(isoDate));
+        }
+        result = result * 10 + (isoDate[i] - '0');
+      }
+      return result;
+    };
+    if(isoDate.size() != 10 || isoDate[4] != '-' || isoDate[7] != '-') {
+      throw std::invalid_argument("not a yyyy-mm-dd date: " + std::string(isoDate));
+    }
+    auto const year = static_cast<std::int32_t>(digits(0, 4));
+    auto const month = digits(5, 7);
+    auto const day = digits(8, 10);
+    daysSinceEpoch = daysFromCivil(year, month, day);
+    auto const civil = toCivil();
+    if(civil.year != year || civil.month != month || civil.day != day) {
+      throw std::invalid_argument("no such date: " + std::string(isoDate));
+    }
+  }
+
+  constexpr std::int32_t getDaysSinceEpoch() const { return daysSinceEpoch; }
+
+  constexpr Civil toCivil() const {
+    auto const days = daysSinceEpoch + 719468;
+    auto const era = (days >= 0 ? days : days - 146096) / 146097;
+    auto const dayOfEra = static_cast<std::uint32_t>(days - era * 146097);
+    auto const yearOfEra =
+        (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    auto const dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    auto const shiftedMonth = (5 * dayOfYear + 2) / 153;
+    auto const day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+    auto const month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+    return {static_cast<std::int32_t>(yearOfEra) + era * 400 + (month <= 2 ? 1 : 0), month, day};
+  }
+
+  std::string toString() const {
+    auto const civil = toCivil();
+    // room for the full ranges of the fields, so that nothing can be truncated
+    std::array<char, sizeof("-2147483648-4294967295-4294967295")> buffer{};
+    std::snprintf(buffer.data(), buffer.size(), "%04d-%02u-%02u", civil.year, civil.month,
+                  civil.day);
+    return buffer.data();
+  }
+
+  constexpr bool operator==(Date const& other) const {
+    return daysSinceEpoch == other.daysSinceEpoch;
+  }
+  constexpr bool operator!=(Date const& other) const { return !(*this == other); }
+  constexpr bool operator<(Date const& other) const {
+    return daysSinceEpoch < other.daysSinceEpoch;
+  }
+  constexpr bool operator>(Date const& other) const { return other < *this; }
+  constexpr bool operator<=(Date const& other) const { return !(other < *this); }
+  constexpr bool operator>=(Date const& other) const { return !(*this < other); }
+
+  friend ::std::ostream& operator<<(::std::ostream& out, Date const& date) {
+    return out << "DateObject[\"" << date.toString() << "\"]";
+  }
+};
+
+/**
+ * A fixed-point decimal number, stored as a 64-bit integer count of 10^-scale units. The scale is
+ * fixed (rather than per value) so that spans of decimals are plain integer arrays and arithmetic
+ * on them is integer arithmetic: sums are exact and additions vectorize. A scale of four keeps the
+ * product of two DECIMAL(15,2) values (e.g., a price times a discount) exact. Results outside of
+ * the representable range wrap around (two's complement), which sumOverflows, differenceOverflows
+ * and productOverflows detect.
+ */
+class Decimal {
+  std::int64_t unscaledValue = 0;
+
+  static constexpr std::int64_t wrap(std::uint64_t value) {
+    return static_cast<std::int64_t>(value);
+  }
+  static constexpr bool add(std::int64_t a, std::int64_t b, std::int64_t& result) {
+    result = wrap(static_cast<std::uint64_t>(a) + static_cast<std::uint64_t>(b));
+    return ((a ^ result) & (b ^ result)) < 0; // NOLINT(hicpp-signed-bitwise): the sign flipped
+  }
+  static constexpr bool multiply(std::int64_t a, std::int64_t b, std::int64_t& result) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_mul_overflow(a, b, &result);
+#else
+    result = wrap(static_cast<std::uint64_t>(a) * static_cast<std::uint64_t>(b));
+    return a != 0 && ((a == -1 && b == INT64_MIN) || result / a != b);
+#endif
+  }
+  /**
+   * the product is rounded (half away from zero) to the scale. It is computed without 128-bit
+   * intermediates: if both factors are small enough, the unscaled product fits 64 bits.
+   * Otherwise, with a = a1 * unit + a0 and b = b1 * unit + b0, a * b / unit is
+   * a1 * b + a0 * b1 + a0 * b0 / unit, and only the last term (which has the sign of the product)
+   * needs rounding. Returns whether the product overflowed (the result wraps around)
+   */
+  constexpr bool multiply(Decimal other, std::int64_t& result) const {
+    constexpr auto largestSmallFactor = std::int64_t(3037000499); // floor(sqrt(2^63 - 1))
+    if(unscaledValue <= largestSmallFactor && unscaledValue >= -largestSmallFactor &&
+       other.unscaledValue <= largestSmallFactor && other.unscaledValue >= -largestSmallFactor) {
+      auto const product = unscaledValue * other.unscaledValue;
+      result = (product + (product < 0 ? -unit / 2 : unit / 2)) / unit;
+      return false;
+    }
+    auto const a1 = unscaledValue / unit;
+    auto const a0 = unscaledValue % unit;
+    auto const b1 = other.unscaledValue / unit;
+    auto const b0 = other.unscaledValue % unit;
+    auto const fraction = a0 * b0;
+    auto const rounded = (fraction + (fraction < 0 ? -unit / 2 : unit / 2)) / unit;
+    auto const overflowed = multiply(a1, other.unscaledValue, result); // a0 * b1 cannot overflow
+    return add(result, a0 * b1, result) | add(result, rounded, result) | overflowed;
+  }
+
+public:
+  static constexpr size_t scale = 4;
+  static constexpr std::int64_t unit = 10000; // 10^scale
+
+  Decimal() = default;
+  static constexpr Decimal fromUnscaledValue(std::int64_t unscaledValue) {
+    auto result = Decimal();
+    result.unscaledValue = unscaledValue;
+    return result;
+  }
+  /**
+   * parses a decimal number ([-]digits[.digits]) with at most scale fractional digits and throws
+   * std::invalid_argument for anything else (including values that do not fit)
+   */
+  explicit Decimal(std::string_view number) {
+    auto const invalid = [&number]() {
+      return std::invalid_argument("not a decimal number: " + std::string(number));
+    };
+    auto const negative = !number.empty() && number[0] == '-';
+    auto const point = number.find('.');
+    auto const integerDigits = number.substr(negative ? 1 : 0, point - (negative ? 1 : 0));
+    auto const fractionalDigits =
+        point == std::string_view::npos ? std::string_view() : number.substr(point + 1);
+    if(integerDigits.empty() || integerDigits.size() > 18 - scale ||
+       fractionalDigits.size() > scale ||
+       (point != std::string_view::npos && fractionalDigits.empty())) {
+      throw invalid();
+    }
+    auto magnitude = std::int64_t(0);
+    for(auto digit : integerDigits) {
+      if(digit < '0' || digit > '9') {
+        throw invalid();
+      }
+      magnitude = magnitude * 10 + (digit - '0');
+    }
+    for(auto i = size_t(0); i < scale; i++) {
+      auto const digit = i < fractionalDigits.size() ? fractionalDigits[i] : '0';
+      if(digit < '0' || digit > '9') {
+        throw invalid();
+      }
+      magnitude = magnitude * 10 + (digit - '0');
+    }
+    unscaledValue = negative ? -magnitude : magnitude;
+  }
+
+  constexpr std::int64_t getUnscaledValue() const { return unscaledValue; }
+  constexpr double toDouble() const { return double(unscaledValue) / double(unit); }
+
+  std::string toString() const {
+    auto const magnitude = unscaledValue < 0 ? std::uint64_t(0) - std::uint64_t(unscaledValue)
+                                             : std::uint64_t(unscaledValue);
+    std::array<char, 32> buffer{};
+    std::snprintf(buffer.data(), buffer.size(), "%s%llu.%04llu", unscaledValue < 0 ? "-" : "",
+                  static_cast<unsigned long long>(magnitude / unit),  // NOLINT(google-runtime-int)
+                  static_cast<unsigned long long>(magnitude % unit)); // NOLINT(google-runtime-int)
+    return buffer.data();
+  }
+
+  constexpr Decimal operator+(Decimal other) const {
+    auto result = std::int64_t(0);
+    add(unscaledValue, other.unscaledValue, result);
+    return fromUnscaledValue(result);
+  }
+  constexpr Decimal operator-(Decimal other) const { return *this + -other; }
+  constexpr Decimal operator-() const {
+    return fromUnscaledValue(wrap(std::uint64_t(0) - static_cast<std::uint64_t>(unscaledValue)));
+  }
+  /**
+   * see multiply for the rounding
+   */
+  constexpr Decimal operator*(Decimal other) const {
+    auto result = std::int64_t(0);
+    multiply(other, result);
+    return fromUnscaledValue(result);
+  }
+  constexpr bool sumOverflows(Decimal other) const {
+    auto result = std::int64_t(0);
+    return add(unscaledValue, other.unscaledValue, result);
+  }
+  constexpr bool differenceOverflows(Decimal other) const {
+    return other.unscaledValue == INT64_MIN ? unscaledValue >= 0 : sumOverflows(-other);
+  }
+  constexpr bool productOverflows(Decimal other) const {
+    auto result = std::int64_t(0);
+    return multiply(other, result);
+  }
+  constexpr Decimal& operator+=(Decimal other) { return *this = *this + other; }
+  constexpr Decimal& operator-=(Decimal other) { return *this = *this - other; }
+  constexpr Decimal& operator*=(Decimal other) { return *this = *this * other; }
+
+  constexpr bool operator==(Decimal const& other) const {
+    return unscaledValue == other.unscaledValue;
+  }
+  constexpr bool operator!=(Decimal const& other) const { return !(*this == other); }
+  constexpr bool operator<(Decimal const& other) const {
+    return unscaledValue < other.unscaledValue;
+  }
+  constexpr bool operator>(Decimal const& other) const { return other < *this; }
+  constexpr bool operator<=(Decimal const& other) const { return !(other < *this); }
+  constexpr bool operator>=(Decimal const& other) const { return !(*this < other); }
+
+  friend ::std::ostream& operator<<(::std::ostream& out, Decimal const& decimal) {
+    return out << decimal.toString();
+  }
+};
+// NOLINTEND(*-magic-numbers)
+
+/**
+ * A type-erased handle to whatever owns the buffer of a span: a pointer to an intrusively
+ * reference-counted control block that holds the owner (e.g., the adapted std::vector) in place.
+ * Taking ownership is a single allocation and the handle is a single pointer. Copying the handle
+ * (which only happens for shared spans) bumps the reference count.
+ */
+class SpanOwnership {
+  struct ControlBlock {
+    std::atomic<size_t> references{1};
+    bool shared = false;
+    void (*destroy)(ControlBlock*);
+    explicit ControlBlock(void (*destroy)(ControlBlock*)) : destroy(destroy) {}
+  };
+  template <typename Owner> struct OwningControlBlock : ControlBlock {
+    Owner owner;
+    explicit OwningControlBlock(Owner&& owner)
+        : ControlBlock([](ControlBlock* block) {
+            delete static_cast<OwningControlBlock*>(block); // NOLINT(*-owning-memory)
+          }),
+          owner(std::move(owner)) {}
+  };
+  /**
+   * for spans constructed with a destructor function: the function is called on release
+   */
+  struct DestructorCall {
+    std::function<void(void)> destructor;
+    explicit DestructorCall(std::function<void(void)>&& destructor)
+        : destructor(std::move(destructor)) {}
+    DestructorCall(DestructorCall&& other) noexcept : destructor(std::move(other.destructor)) {
+      other.destructor = nullptr;
+    }
+    DestructorCall(DestructorCall const&) = delete;
+    DestructorCall& operator=(DestructorCall const&) = delete;
+    DestructorCall& operator=(DestructorCall&&) = delete;
+    ~DestructorCall() {
+      if(destructor) {
+        destructor();
+      }
+    }
+  };
+
+  ControlBlock* block = nullptr;
+
+  explicit SpanOwnership(ControlBlock* block) : block(block) {}
+
+public:
+  SpanOwnership() noexcept = default;
+
+  template <typename Owner> static SpanOwnership own(Owner&& owner) {
+    return SpanOwnership(new OwningControlBlock<std::decay_t<Owner>>(std::forward<Owner>(owner)));
+  }
+
+  static SpanOwnership call(std::function<void(void)>&& destructor) {
+    if(!destructor) {
+      return {};
+    }
+    return own(DestructorCall(std::move(destructor)));
+  }
+
+  SpanOwnership(SpanOwnership const& other) noexcept : block(other.block) {
+    if(block != nullptr) {
+      block->references.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  SpanOwnership(SpanOwnership&& other) noexcept : block(std::exchange(other.block, nullptr)) {}
+  SpanOwnership& operator=(SpanOwnership const& other) noexcept {
+    SpanOwnership(other).swap(*this);
+    return *this;
+  }
+  SpanOwnership& operator=(SpanOwnership&& other) noexcept {
+    SpanOwnership(std::move(other)).swap(*this);
+    return *this;
+  }
+  ~SpanOwnership() {
+    if(block != nullptr && block->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      block->destroy(block);
+    }
+  }
+  void swap(SpanOwnership& other) noexcept { std::swap(block, other.block); }
+
+  bool owns() const { return block != nullptr; }
+  bool isShared() const { return block != nullptr && block->shared; }
+  /**
+   * marks the buffer as shared: from now on, clones of the span hold a reference to it instead of
+   * a copy
+   */
+  void share() {
+    if(block != nullptr) {
+      block->shared = true;
+    }
+  }
+  size_t useCount() const {
+    return block != nullptr ? block->references.load(std::memory_order_acquire) : 0;
+  }
+};
+
+/**
+ * Bits packed into 64-bit words, Arrow-style (least significant bit first). The words are
+ * immutable and shared, so copying (and slicing) a bitmap never copies them. The number of set
+ * bits is computed once, when a bitmap (or a slice of one) is made, so asking for it is cheap. The
+ * bulk operations work a word at a time (and produce bitmaps that start at a word boundary).
+ */
+class Bitmap {
+public:
+  using Word = std::uint64_t;
+  static constexpr size_t bitsPerWord = 64;
+
+private:
+  std::shared_ptr<std::vector<Word> const> words;
+  size_t offset = 0; // in bits, slices share the words of the bitmap they were taken from
+  size_t count = 0;
+  size_t ones = 0;
+
+  Bitmap(std::shared_ptr<std::vector<Word> const> words, size_t offset, size_t size)
+      : words(std::move(words)), offset(offset), count(size) {
+    for(auto i = size_t(0); i < wordCount(); i++) {
+      ones += std::bitset<bitsPerWord>(word(i)).count();
+    }
+  }
+
+  template <typename Operator> Bitmap combine(Bitmap const& other, Operator&& op) const {
+    if(other.size() != size()) {
+      throw std::invalid_argument("bitmap sizes differ");
+    }
+    auto result = std::vector<Word>(wordCount());
+    for(auto i = size_t(0); i < result.size(); i++) {
+      result[i] = op(word(i), other.word(i));
+    }
+    return {std::move(result), count};
+  }
+
+public:
+  Bitmap() noexcept = default;
+
+  explicit Bitmap(std::vector<bool> const& bits)
+      : Bitmap(
+            [&bits]() {
+              auto words = std::vector<Word>((bits.size() + bitsPerWord - 1) / bitsPerWord);
+              for(auto i = size_t(0); i < bits.size(); i++) {
+                words[i / bitsPerWord] |= Word(bits[i]) << (i % bitsPerWord);
+              }
+              return std::make_shared<std::vector<Word> const>(std::move(words));
+            }(),
+            0, bits.size()) {}
+
+  /**
+   * Adopts words that are already packed (e.g., a loaded Arrow buffer) for size bits
+   */
+  Bitmap(std::vector<Word>&& words, size_t size)
+      : Bitmap(
+            [&words, size]() {
+              if(words.size() * bitsPerWord < size) {
+                throw std::invalid_argument("bitmap has fewer words than bits");
+              }
+              return std::make_shared<std::vector<Word> const>(std::move(words));
+            }(),
+            0, size) {}
+
+  bool hasWords() const { return words != nullptr; }
+  size_t size() const { return count; }
+  size_t popcount() const { return ones; }
+  bool operator[](size_t index) const {
+    auto const bit = offset + index;
+    return ((*words)[bit / bitsPerWord] >> (bit % bitsPerWord) & Word(1)) != 0;
+  }
+
+  /**
+   * the packed words and the position of the first bit in them
+   */
+  Word const* wordData() const { return words ? words->data() : nullptr; }
+  size_t bitOffset() const { return offset; }
+
+  size_t wordCount() const { return (count + bitsPerWord - 1) / bitsPerWord; }
+
+  /**
+   * the bits [i * 64, i * 64 + 64) of the bitmap, aligned to the start of the bitmap (the bits
+   * past the end are zero), so loops over the bits of slices can go a word at a time
+   */
+  Word word(size_t i) const {
+    auto const bit = offset + i * bitsPerWord;
+    auto const shift = bit % bitsPerWord;
+    auto result = (*words)[bit / bitsPerWord] >> shift;
+    if(shift > 0 && bit / bitsPerWord + 1 < words->size()) {
+      result |= (*words)[bit / bitsPerWord + 1] << (bitsPerWord - shift);
+    }
+    auto const valid = count - i * bitsPerWord;
+    return valid < bitsPerWord ? result & ((Word(1) << valid) - 1) : result;
+  }
+
+  /**
+   * the bits [first, first + size), sharing the words
+   */
+  Bitmap slice(size_t first, size_t size) const {
+    if(!words) {
+      return {};
+    }
+    return {words, offset + first, size};
+  }
+
+  Bitmap operator&(Bitmap const& other) const {
+    return combine(other, [](Word left, Word right) { return left & right; });
+  }
+  Bitmap operator|(Bitmap const& other) const {
+    return combine(other, [](Word left, Word right) { return left | right; });
+  }
+  Bitmap operator~() const {
+    return combine(*this, [](Word value, Word /*unused*/) { return ~value; });
+  }
+  bool operator==(Bitmap const& other) const {
+    if(other.size() != size() || other.popcount() != popcount()) {
+      return false;
+    }
+    for(auto i = size_t(0); i < wordCount(); i++) {
+      if(word(i) != other.word(i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  bool operator!=(Bitmap const& other) const { return !(*this == other); }
+
+  /**
+   * calls visitor(index) for every set bit, in order (skipping a word of clear bits at a time)
+   */
+  template <typename Visitor> void forEachSetBit(Visitor&& visitor) const {
+    for(auto i = size_t(0); i < wordCount(); i++) {
+      for(auto bits = word(i); bits != 0; bits &= bits - 1) {
+        visitor(i * bitsPerWord + std::bitset<bitsPerWord>((bits & (~bits + 1)) - 1).count());
+      }
+    }
+  }
+};
+
+/**
+ * Marks which elements of a span are valid (i.e., not missing), one bit per element (see Bitmap,
+ * so null checks can be done a word at a time). A default-constructed validity bitmap is absent:
+ * all elements are valid.
+ */
+class ValidityBitmap {
+  Bitmap bits;
+
+public:
+  using Word = Bitmap::Word;
+
+  ValidityBitmap() noexcept = default;
+  explicit ValidityBitmap(Bitmap bits) : bits(std::move(bits)) {}
+
+  /**
+   * Packs the flags (true means valid)
+   */
+  explicit ValidityBitmap(std::vector<bool> const& valid) : bits(valid) {}
+
+  /**
+   * Adopts words that are already packed (e.g., a loaded Arrow validity buffer) for size elements
+   */
+  ValidityBitmap(std::vector<Word>&& words, size_t size) : bits(std::move(words), size) {}
+
+  bool isPresent() const { return bits.hasWords(); }
+  Bitmap const& getBits() const { return bits; }
+  size_t size() const { return bits.size(); }
+  size_t nullCount() const { return bits.size() - bits.popcount(); }
+  bool isValid(size_t index) const { return !bits.hasWords() || bits[index]; }
+  Word const* wordData() const { return bits.wordData(); }
+  size_t bitOffset() const { return bits.bitOffset(); }
+  ValidityBitmap slice(size_t first, size_t size) const {
+    return ValidityBitmap(bits.slice(first, size));
+  }
+
+  /**
+   * the elements that are valid in both
+   */
+  ValidityBitmap operator&(ValidityBitmap const& other) const {
+    if(!isPresent()) {
+      return other;
+    }
+    if(!other.isPresent()) {
+      return *this;
+    }
+    return ValidityBitmap(bits & other.bits);
+  }
+};
+
+template <typename Scalar> struct Span {
+private: // state
+  using IteratorType = std::conditional_t<
+      std::is_same_v<std::remove_const_t<Scalar>, bool>,
+      std::conditional_t<std::is_const_v<Scalar>, typename std::vector<bool>::const_iterator,
+                         typename std::vector<bool>::iterator>,
+      Scalar*>;
+  using ConstIteratorType =
+      std::conditional_t<std::is_same_v<std::remove_const_t<Scalar>, bool>,
+                         typename std::vector<bool>::const_iterator, Scalar const*>;
+  IteratorType _begin = {};
+  IteratorType _end = {};
+  SpanOwnership ownership; // empty for spans that do not own their buffer
+  ValidityBitmap validity;
+
+  template <typename> friend struct Span;
+  Span(SpanOwnership ownership, IteratorType begin, size_t size, ValidityBitmap validity)
+      : _begin(begin), _end(begin + size), ownership(std::move(ownership)),
+        validity(std::move(validity)) {}
+
+public: // surface
+  using element_type = Scalar;
+  size_t size() const { return _end - _begin; }
+  constexpr auto operator[](size_t index) const -> decltype(auto) {
+    return *(ConstIteratorType(_begin) + index);
+  }
+  constexpr auto operator[](size_t index) -> decltype(auto) {
+    unshare();
+    return *(_begin + index);
+  }
+
+  /**
+   * Iteration is read-only, so that writes cannot reach the clones that share the buffer: write
+   * through mutableBegin() and mutableEnd(), which unshare it first (see unshare())
+   */
+  ConstIteratorType begin() const { return _begin; }
+  ConstIteratorType end() const { return _end; }
+  IteratorType mutableBegin() {
+    unshare();
+    return _begin;
+  }
+  IteratorType mutableEnd() {
+    unshare();
+    return _end;
+  }
+
+  constexpr auto at(size_t index) const -> decltype(auto) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay,hicpp-no-array-decay)
+    if(_begin + index < _end) {
+      return (*this)[index];
+    }
+    throw std::out_of_range("Span has no element with index " + std::to_string(index));
+  }
+  constexpr auto at(size_t index) -> decltype(auto) {
+    unshare();
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay,hicpp-no-array-decay)
+    if(_begin + index < _end) {
+      return (*this)[index];
+    }
+    throw std::out_of_range("Span has no element with index " + std::to_string(index));
+  }
+
+  constexpr Span<Scalar> subspan(size_t offset, size_t size) && {
+    _begin += offset;
+    _end = _begin + size;
+    validity = validity.slice(offset, size);
+    return std::move(*this);
+  }
+
+  constexpr Span<Scalar> subspan(size_t offset) && {
+    return std::move(*this).subspan(offset, _end - _begin - offset);
+  }
+
+  /**
+   * The span takes ownership of the adaptee
+   */
+  explicit Span(std::vector<std::remove_const_t<Scalar>>&& adaptee)
+      : _begin([&/* capturing context for immediate evaluation */]() {
+          if constexpr(std::is_same_v<Scalar, bool>) {
+            return adaptee.begin();
+          } else {
+            return adaptee.data();
+          }
+        }()),
+        _end(_begin + adaptee.size()), ownership(SpanOwnership::own(std::move(adaptee))) {}
+
+  /**
+   * The span shares ownership of the adaptee (see share())
+   */
+  explicit Span(std::shared_ptr<std::vector<std::remove_const_t<Scalar>>> adaptee)
+      : _begin([&adaptee]() -> IteratorType {
+          if constexpr(std::is_same_v<std::remove_const_t<Scalar>, bool>) {
+            return adaptee->begin();
+          } else {
+            return adaptee->data();
+          }
+        }()),
+        _end(_begin + adaptee->size()), ownership(SpanOwnership::own(std::move(adaptee))) {
+    ownership.share();
+  }
+
+  /**
+   * The span does not take ownership of the adaptee. The vector better not be modified while the
+   * span lives
+   */
+  explicit Span(std::vector<std::remove_const_t<Scalar>>& adaptee)
+      : _begin([&adaptee]() {
+          if constexpr(std::is_same_v<Scalar, bool>) {
+            return adaptee.begin();
+          } else {
+            return adaptee.data();
+          }
+        }()),
+        _end(_begin + adaptee.size()) {}
+
+  /**
+   * The span does not take ownership of the adaptee. The vector better not be modified while the
+   * span lives
+   */
+  explicit Span(std::vector<std::remove_const_t<Scalar>> const& adaptee)
+      : _begin([&adaptee]() {
+          if constexpr(std::is_same_v<Scalar, bool>) {
+            return adaptee.begin();
+          } else {
+            return adaptee.data();
+          }
+        }()),
+        _end(_begin + adaptee.size()) {}
+
+  /**
+   * The span takes ownership through the destructor, which is called (once) when the last span
+   * referring to the buffer is destroyed
+   */
+  explicit Span(IteratorType begin, size_t size, std::function<void(void)> destructor)
+      : _begin(begin), _end(begin + size), ownership(SpanOwnership::call(std::move(destructor))) {}
+
+  bool operator==(Span const& other) const { return _begin == other._begin; }
+
+  Span() noexcept = default;
+
+  /**
+   * We consider Spans move-only because they can be *really* expensive to copy. It you really,
+   * really have to copy one, use the clone() function and provide a reason
+   */
+  Span(Span const& other) = delete;
+  Span(Span&& other) noexcept = default;
+
+  /**
+   * because the Span constructor cannot infer what data structure/payload was used to hold the
+   * values in the other Span, arguments are copied into a std::vector. Shared spans are the
+   * exception: their clones share the (reference-counted) buffer, so cloning them is O(1)
+   */
+  template <typename... Reason> Span<std::remove_const_t<Scalar>> clone(Reason... reason) const& {
+    checkCloneWithoutReason(reason...);
+    // a vector<bool>::const_iterator cannot be turned back into a (mutable) iterator
+    if constexpr(!std::is_same_v<Scalar, bool const>) {
+      if(ownership.isShared()) {
+        if constexpr(std::is_const_v<Scalar>) {
+          // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+          return {ownership, const_cast<std::remove_const_t<Scalar>*>(_begin), size(), validity};
+        } else {
+          return {ownership, _begin, size(), validity};
+        }
+      }
+    }
+    return Span<std::remove_const_t<Scalar>>(
+               std::vector<std::remove_const_t<Scalar>>(_begin, _end))
+        .withValidity(validity);
+  }
+
+  /**
+   * Turns the span into a shared span: ownership of the buffer moves into a reference-counted
+   * handle that is shared by all clones of the span. A span that does not own its buffer copies
+   * it first (clones would otherwise outlive the buffer). Shared spans are copy-on-write: mutable
+   * element access copies the buffer if it is shared with other spans (see unshare())
+   */
+  Span share() && {
+    if(!ownership.owns()) {
+      return Span(std::make_shared<std::vector<std::remove_const_t<Scalar>>>(_begin, _end))
+          .withValidity(std::move(validity));
+    }
+    ownership.share();
+    return std::move(*this);
+  }
+
+  bool isShared() const { return ownership.isShared(); }
+
+  /**
+   * see ValidityBitmap: the values of elements that are not valid (i.e., missing) are unspecified
+   */
+  ValidityBitmap const& getValidity() const { return validity; }
+  bool isValid(size_t index) const { return validity.isValid(index); }
+  size_t nullCount() const { return validity.nullCount(); }
+  Span withValidity(ValidityBitmap validity) && {
+    if(validity.isPresent() && validity.size() != size()) {
+      throw std::invalid_argument("validity bitmap and span sizes differ");
+    }
+    this->validity = std::move(validity);
+    return std::move(*this);
+  }
+
+  /**
+   * Makes the span the sole owner of its buffer, copying the elements if any other span shares
+   * it. This is called implicitly by mutable element access
+   */
+  void unshare() {
+    if constexpr(!std::is_const_v<Scalar>) {
+      if(ownership.isShared() && ownership.useCount() > 1) {
+        *this = Span(std::make_shared<std::vector<Scalar>>(_begin, _end))
+                    .withValidity(std::move(validity));
+      }
+    }
+  }
+
+  Span& operator=(Span&& other) noexcept = default;
+
+  /**
+   * see comment on the copy constructor about copying Spans
+   */
+  Span& operator=(Span const&) = delete;
+  ~Span() = default;
+
+  friend std::ostream& operator<<(std::ostream& stream, Span const& span) {
+    return stream << span.size;
+  }
+};
+
+/**
+ * A column of strings stored Arrow-style: one contiguous buffer of characters plus size() + 1
+ * offsets into it (element i is the characters [offsets[i], offsets[i + 1])). Unlike a
+ * Span<std::string>, there is no allocation per string and scans stream through contiguous memory.
+ * The elements are std::string_views into the buffer (so they are immutable).
+ */
+template <> struct Span<std::string_view> {
+  using Offset = std::int64_t; // the offset type of Arrow's large strings
+
+private: // state
+  char const* characters = nullptr;
+  Offset const* offsets = nullptr; // size() + 1 of them (unless the span is empty)
+  size_t count = 0;
+  SpanOwnership ownership; // empty for spans that do not own their buffers
+  ValidityBitmap validity;
+
+  struct Buffers {
+    std::vector<char> characters;
+    std::vector<Offset> offsets;
+  };
+  explicit Span(Buffers&& buffers)
+      : characters(buffers.characters.data()), offsets(buffers.offsets.data()),
+        count(buffers.offsets.empty() ? 0 : buffers.offsets.size() - 1),
+        ownership(SpanOwnership::own(std::move(buffers))) {}
+  Span(SpanOwnership ownership, char const* characters, Offset const* offsets, size_t count,
+       ValidityBitmap validity)
+      : characters(characters), offsets(offsets), count(count), ownership(std::move(ownership)),
+        validity(std::move(validity)) {}
+
+  /**
+   * copies the characters of the elements into a new buffer (rebasing the offsets to zero)
+   */
+  Buffers copyBuffers() const {
+    auto buffers = Buffers();
+    if(count > 0) {
+      buffers.characters.assign(characters + offsets[0], characters + offsets[count]);
+      buffers.offsets.reserve(count + 1);
+      std::transform(offsets, offsets + count + 1, std::back_inserter(buffers.offsets),
+                     [base = offsets[0]](Offset offset) { return offset - base; });
+    }
+    return buffers;
+  }
+
+public: // surface
+  using element_type = std::string_view;
+
+  class Iterator {
+    char const* characters = nullptr;
+    Offset const* offsets = nullptr;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = std::string_view;
+
+    Iterator() noexcept = default;
+    Iterator(char const* characters, Offset const* offsets)
+        : characters(characters), offsets(offsets) {}
+
+    std::string_view operator*() const {
+      return {characters + offsets[0], static_cast<size_t>(offsets[1] - offsets[0])};
+    }
+    std::string_view operator[](difference_type n) const { return *(*this + n); }
+
+    Iterator& operator++() {
+      ++offsets;
+      return *this;
+    }
+    Iterator operator++(int) { return {characters, offsets++}; }
+    Iterator& operator--() {
+      --offsets;
+      return *this;
+    }
+    Iterator operator--(int) { return {characters, offsets--}; }
+    Iterator& operator+=(difference_type n) {
+      offsets += n;
+      return *this;
+    }
+    Iterator& operator-=(difference_type n) {
+      offsets -= n;
+      return *this;
+    }
+    friend Iterator operator+(Iterator it, difference_type n) { return it += n; }
+    friend Iterator operator+(difference_type n, Iterator it) { return it += n; }
+    friend Iterator operator-(Iterator it, difference_type n) { return it -= n; }
+    friend difference_type operator-(Iterator const& left, Iterator const& right) {
+      return left.offsets - right.offsets;
+    }
+    bool operator==(Iterator const& other) const { return offsets == other.offsets; }
+    bool operator!=(Iterator const& other) const { return offsets != other.offsets; }
+    bool operator<(Iterator const& other) const { return offsets < other.offsets; }
+    bool operator>(Iterator const& other) const { return offsets > other.offsets; }
+    bool operator<=(Iterator const& other) const { return offsets <= other.offsets; }
+    bool operator>=(Iterator const& other) const { return offsets >= other.offsets; }
+  };
+
+  size_t size() const { return count; }
+  std::string_view operator[](size_t index) const { return begin()[index]; }
+  std::string_view at(size_t index) const {
+    if(index < count) {
+      return (*this)[index];
+    }
+    throw std::out_of_range("Span has no element with index " + std::to_string(index));
+  }
+  Iterator begin() const { return {characters, offsets}; }
+  Iterator end() const { return {characters, offsets + count}; }
+
+  /**
+   * the bytes of all elements (which are adjacent in the buffer)
+   */
+  std::string_view characterData() const {
+    return count == 0 ? std::string_view()
+                      : std::string_view(characters + offsets[0],
+                                         static_cast<size_t>(offsets[count] - offsets[0]));
+  }
+
+  Span subspan(size_t offset, size_t size) && {
+    offsets += offset;
+    count = size;
+    validity = validity.slice(offset, size);
+    return std::move(*this);
+  }
+  Span subspan(size_t offset) && { return std::move(*this).subspan(offset, count - offset); }
+
+  /**
+   * Copies the strings into a single buffer
+   */
+  explicit Span(std::vector<std::string> const& strings) : Span([&strings]() {
+    auto buffers = Buffers();
+    buffers.offsets.reserve(strings.size() + 1);
+    buffers.offsets.push_back(0);
+    for(auto const& string : strings) {
+      buffers.offsets.push_back(buffers.offsets.back() + static_cast<Offset>(string.size()));
+    }
+    buffers.characters.reserve(buffers.offsets.back());
+    for(auto const& string : strings) {
+      buffers.characters.insert(buffers.characters.end(), string.begin(), string.end());
+    }
+    return buffers;
+  }()) {}
+
+  /**
+   * The span takes ownership of the buffers (offsets has one more entry than there are strings)
+   */
+  Span(std::vector<char>&& characters, std::vector<Offset>&& offsets)
+      : Span(Buffers{std::move(characters), std::move(offsets)}) {}
+
+  /**
+   * Zero-copy construction from buffers that are already laid out this way (e.g., loaded Arrow
+   * large_string arrays): the span takes ownership through the destructor, which is called (once)
+   * when the last span referring to the buffers is destroyed. Without a destructor, the buffers
+   * better outlive the span
+   */
+  Span(char const* characters, Offset const* offsets, size_t size,
+       std::function<void(void)> destructor)
+      : characters(characters), offsets(offsets), count(size),
+        ownership(SpanOwnership::call(std::move(destructor))) {}
+
+  bool operator==(Span const& other) const { return offsets == other.offsets; }
+
+  Span() noexcept = default;
+  Span(Span const& other) = delete;
+  Span(Span&& other) noexcept = default;
+  Span& operator=(Span&& other) noexcept = default;
+  Span& operator=(Span const&) = delete;
+  ~Span() = default;
+
+  /**
+   * see Span::clone -- the characters and offsets are copied into new buffers unless the span is
+   * shared
+   */
+  template <typename... Reason> Span clone(Reason... reason) const& {
+    checkCloneWithoutReason(reason...);
+    if(ownership.isShared()) {
+      return {ownership, characters, offsets, count, validity};
+    }
+    return Span(copyBuffers()).withValidity(validity);
+  }
+
+  /**
+   * see Span::share -- the buffers are immutable, so shared string spans are never copied again
+   */
+  Span share() && {
+    if(!ownership.owns()) {
+      auto shared = Span(copyBuffers()).withValidity(std::move(validity));
+      shared.ownership.share();
+      return shared;
+    }
+    ownership.share();
+    return std::move(*this);
+  }
+
+  bool isShared() const { return ownership.isShared(); }
+
+  /**
+   * see Span::getValidity
+   */
+  ValidityBitmap const& getValidity() const { return validity; }
+  bool isValid(size_t index) const { return validity.isValid(index); }
+  size_t nullCount() const { return validity.nullCount(); }
+  Span withValidity(ValidityBitmap validity) && {
+    if(validity.isPresent() && validity.size() != size()) {
+      throw std::invalid_argument("validity bitmap and span sizes differ");
+    }
+    this->validity = std::move(validity);
+    return std::move(*this);
+  }
+
+  friend std::ostream& operator<<(std::ostream& stream, Span const& span) {
+    return stream << span.size();
+  }
+};
+
+/**
+ * The element tag of dictionary-encoded string columns, see Span<DictionaryEncoded>
+ */
+struct DictionaryEncoded {};
+
+/**
+ * A column of strings with few distinct values (flags, segments, countries, ...): every element is
+ * a small integer code into a dictionary of the distinct values. The dictionary is a string span
+ * that is shared (and never copied) between all spans of the column, so engines can compare, group
+ * and join on the codes directly (codes are equal iff the values are, as long as the dictionaries
+ * are the same, see sharesDictionaryWith). Like string spans, the elements are std::string_views.
+ */
+template <> struct Span<DictionaryEncoded> {
+  using Code = std::int32_t;
+  using Dictionary = std::shared_ptr<Span<std::string_view> const>;
+
+private: // state
+  Code const* codes = nullptr;
+  size_t count = 0;
+  SpanOwnership ownership; // of the codes only, the dictionary is owned through the shared_ptr
+  Dictionary dictionary;
+  ValidityBitmap validity;
+
+  Span(SpanOwnership ownership, Code const* codes, size_t count, Dictionary dictionary,
+       ValidityBitmap validity)
+      : codes(codes), count(count), ownership(std::move(ownership)),
+        dictionary(std::move(dictionary)), validity(std::move(validity)) {}
+  explicit Span(std::pair<std::vector<Code>, Dictionary>&& encoded)
+      : Span(std::move(encoded.first), std::move(encoded.second)) {}
+
+public: // surface
+  using element_type = std::string_view;
+
+  class Iterator {
+    Code const* codes = nullptr;
+    Span<std::string_view> const* dictionary = nullptr;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = std::string_view;
+
+    Iterator() noexcept = default;
+    Iterator(Code const* codes, Span<std::string_view> const* dictionary)
+        : codes(codes), dictionary(dictionary) {}
+
+    std::string_view operator*() const { return (*dictionary)[*codes]; }
+    std::string_view operator[](difference_type n) const { return *(*this + n); }
+
+    Iterator& operator++() {
+      ++codes;
+      return *this;
+    }
+    Iterator operator++(int) { return {codes++, dictionary}; }
+    Iterator& operator--() {
+      --codes;
+      return *this;
+    }
+    Iterator operator--(int) { return {codes--, dictionary}; }
+    Iterator& operator+=(difference_type n) {
+      codes += n;
+      return *this;
+    }
+    Iterator& operator-=(difference_type n) {
+      codes -= n;
+      return *this;
+    }
+    friend Iterator operator+(Iterator it, difference_type n) { return it += n; }
+    friend Iterator operator+(difference_type n, Iterator it) { return it += n; }
+    friend Iterator operator-(Iterator it, difference_type n) { return it -= n; }
+    friend difference_type operator-(Iterator const& left, Iterator const& right) {
+      return left.codes - right.codes;
+    }
+    bool operator==(Iterator const& other) const { return codes == other.codes; }
+    bool operator!=(Iterator const& other) const { return codes != other.codes; }
+    bool operator<(Iterator const& other) const { return codes < other.codes; }
+    bool operator>(Iterator const& other) const { return codes > other.codes; }
+    bool operator<=(Iterator const& other) const { return codes <= other.codes; }
+    bool operator>=(Iterator const& other) const { return codes >= other.codes; }
+  };
+
+  size_t size() const { return count; }
+  std::string_view operator[](size_t index) const { return begin()[index]; }
+  std::string_view at(size_t index) const {
+    if(index < count) {
+      return (*this)[index];
+    }
+    throw std::out_of_range("Span has no element with index " + std::to_string(index));
+  }
+  Iterator begin() const { return {codes, dictionary.get()}; }
+  Iterator end() const { return {codes + count, dictionary.get()}; }
+
+  /**
+   * the codes of the elements (size() of them)
+   */
+  Code const* codeData() const { return codes; }
+  Span<std::string_view> const& getDictionary() const { return *dictionary; }
+  Dictionary const& getSharedDictionary() const { return dictionary; }
+  bool sharesDictionaryWith(Span const& other) const { return dictionary == other.dictionary; }
+
+  /**
+   * the code of a value (if it is in the dictionary), e.g., to turn a comparison with a constant
+   * into a comparison of codes
+   */
+  std::optional<Code> codeOf(std::string_view value) const {
+    auto const found = std::find(dictionary->begin(), dictionary->end(), value);
+    if(found == dictionary->end()) {
+      return {};
+    }
+    return static_cast<Code>(found - dictionary->begin());
+  }
+
+  Span subspan(size_t offset, size_t size) && {
+    codes += offset;
+    count = size;
+    validity = validity.slice(offset, size);
+    return std::move(*this);
+  }
+  Span subspan(size_t offset) && { return std::move(*this).subspan(offset, count - offset); }
+
+  /**
+   * Encodes the strings (the dictionary holds the distinct values in order of first appearance)
+   */
+  explicit Span(std::vector<std::string> const& strings) : Span([&strings]() {
+    auto codes = std::vector<Code>();
+    codes.reserve(strings.size());
+    auto values = std::vector<std::string>();
+    auto valueCodes = std::unordered_map<std::string_view, Code>();
+    for(auto const& string : strings) {
+      auto [value, inserted] = valueCodes.try_emplace(string, static_cast<Code>(values.size()));
+      if(inserted) {
+        values.push_back(string);
+      }
+      codes.push_back(value->second);
+    }
+    return std::make_pair(std::move(codes),
+                          std::make_shared<Span<std::string_view> const>(values));
+  }()) {}
+
+  /**
+   * The span takes ownership of the codes, which must be valid indexes into the dictionary
+   */
+  Span(std::vector<Code>&& codes, Dictionary dictionary)
+      : codes(codes.data()), count(codes.size()),
+        ownership(SpanOwnership::own(std::move(codes))), dictionary(std::move(dictionary)) {}
+
+  /**
+   * Zero-copy construction from codes that are already loaded (e.g., the indices of Arrow
+   * dictionary arrays): see the corresponding constructor of Span<std::string_view> about the
+   * destructor
+   */
+  Span(Code const* codes, size_t size, Dictionary dictionary, std::function<void(void)> destructor)
+      : codes(codes), count(size), ownership(SpanOwnership::call(std::move(destructor))),
+        dictionary(std::move(dictionary)) {}
+
+  bool operator==(Span const& other) const { return codes == other.codes; }
+
+  Span() noexcept = default;
+  Span(Span const& other) = delete;
+  Span(Span&& other) noexcept = default;
+  Span& operator=(Span&& other) noexcept = default;
+  Span& operator=(Span const&) = delete;
+  ~Span() = default;
+
+  /**
+   * see Span::clone -- the codes are copied unless the span is shared, the dictionary never is
+   */
+  template <typename... Reason> Span clone(Reason... reason) const& {
+    checkCloneWithoutReason(reason...);
+    if(ownership.isShared()) {
+      return {ownership, codes, count, dictionary, validity};
+    }
+    return Span(std::vector<Code>(codes, codes + count), dictionary).withValidity(validity);
+  }
+
+  /**
+   * see Span::share -- the codes are immutable, so shared dictionary spans are never copied again
+   */
+  Span share() && {
+    if(!ownership.owns()) {
+      auto shared = Span(std::vector<Code>(codes, codes + count), dictionary)
+                        .withValidity(std::move(validity));
+      shared.ownership.share();
+      return shared;
+    }
+    ownership.share();
+    return std::move(*this);
+  }
+
+  bool isShared() const { return ownership.isShared(); }
+
+  /**
+   * see Span::getValidity
+   */
+  ValidityBitmap const& getValidity() const { return validity; }
+  bool isValid(size_t index) const { return validity.isValid(index); }
+  size_t nullCount() const { return validity.nullCount(); }
+  Span withValidity(ValidityBitmap validity) && {
+    if(validity.isPresent() && validity.size() != size()) {
+      throw std::invalid_argument("validity bitmap and span sizes differ");
+    }
+    this->validity = std::move(validity);
+    return std::move(*this);
+  }
+
+  friend std::ostream& operator<<(std::ostream& stream, Span const& span) {
+    return stream << span.size();
+  }
+};
+
+/**
+ * The element tag of word-packed boolean columns, see Span<PackedBool>
+ */
+struct PackedBool {};
+
+/**
+ * A column of booleans packed into 64-bit words (see Bitmap), e.g., the result of a predicate.
+ * Unlike Span<bool> (which is backed by std::vector<bool> and goes through its reference proxies),
+ * the elements are plain bools (decoded on access, so they cannot be modified) and predicates are
+ * combined (&, |, ~), counted (popcount) and turned into selections (forEachSetBit) a word at a
+ * time. The words are immutable, so clones (and subspans) share them.
+ */
+template <> struct Span<PackedBool> {
+private:
+  Bitmap bits;
+  ValidityBitmap validity;
+
+  Span(Bitmap bits, ValidityBitmap validity)
+      : bits(std::move(bits)), validity(std::move(validity)) {}
+
+public: // surface
+  using element_type = bool;
+
+  class Iterator {
+    Bitmap const* bits = nullptr;
+    size_t index = 0;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = bool;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = bool;
+
+    Iterator() noexcept = default;
+    Iterator(Bitmap const* bits, size_t index) : bits(bits), index(index) {}
+
+    bool operator*() const { return (*bits)[index]; }
+    bool operator[](difference_type n) const { return *(*this + n); }
+
+    Iterator& operator++() {
+      ++index;
+      return *this;
+    }
+    Iterator operator++(int) { return {bits, index++}; }
+    Iterator& operator--() {
+      --index;
+      return *this;
+    }
+    Iterator operator--(int) { return {bits, index--}; }
+    Iterator& operator+=(difference_type n) {
+      index += n;
+      return *this;
+    }
+    Iterator& operator-=(difference_type n) {
+      index -= n;
+      return *this;
+    }
+    friend Iterator operator+(Iterator it, difference_type n) { return it += n; }
+    friend Iterator operator+(difference_type n, Iterator it) { return it += n; }
+    friend Iterator operator-(Iterator it, difference_type n) { return it -= n; }
+    friend difference_type operator-(Iterator const& left, Iterator const& right) {
+      return difference_type(left.index) - difference_type(right.index);
+    }
+    bool operator==(Iterator const& other) const { return index == other.index; }
+    bool operator!=(Iterator const& other) const { return index != other.index; }
+    bool operator<(Iterator const& other) const { return index < other.index; }
+    bool operator>(Iterator const& other) const { return index > other.index; }
+    bool operator<=(Iterator const& other) const { return index <= other.index; }
+    bool operator>=(Iterator const& other) const { return index >= other.index; }
+  };
+
+  size_t size() const { return bits.size(); }
+  bool operator[](size_t index) const { return bits[index]; }
+  bool at(size_t index) const {
+    if(index < size()) {
+      return (*this)[index];
+    }
+    throw std::out_of_range("Span has no element with index " + std::to_string(index));
+  }
+  Iterator begin() const { return {&bits, 0}; }
+  Iterator end() const { return {&bits, size()}; }
+
+  Bitmap const& getBits() const { return bits; }
+
+  /**
+   * the number of true elements
+   */
+  size_t popcount() const { return bits.popcount(); }
+
+  /**
+   * calls visitor(index) for every true element, in order (e.g., to build a selection)
+   */
+  template <typename Visitor> void forEachSetBit(Visitor&& visitor) const {
+    bits.forEachSetBit(std::forward<Visitor>(visitor));
+  }
+
+  /**
+   * element-wise, the result is missing where either operand is
+   */
+  Span operator&(Span const& other) const {
+    return {bits & other.bits, validity & other.validity};
+  }
+  Span operator|(Span const& other) const {
+    return {bits | other.bits, validity & other.validity};
+  }
+  Span operator~() const { return {~bits, validity}; }
+
+  Span subspan(size_t offset, size_t size) && {
+    bits = bits.slice(offset, size);
+    validity = validity.slice(offset, size);
+    return std::move(*this);
+  }
+  Span subspan(size_t offset) && { return std::move(*this).subspan(offset, size() - offset); }
+
+  explicit Span(std::vector<bool> const& values) : bits(values) {}
+  explicit Span(Bitmap bits) : bits(std::move(bits)) {}
+
+  bool operator==(Span const& other) const {
+    return bits.wordData() == other.bits.wordData() &&
+           bits.bitOffset() == other.bits.bitOffset() && bits.size() == other.bits.size();
+  }
+
+  Span() noexcept = default;
+  Span(Span const& other) = delete;
+  Span(Span&& other) noexcept = default;
+  Span& operator=(Span&& other) noexcept = default;
+  Span& operator=(Span const&) = delete;
+  ~Span() = default;
+
+  /**
+   * see Span::clone -- the words are immutable, so they are always shared
+   */
+  template <typename... Reason> Span clone(Reason... reason) const& {
+    checkCloneWithoutReason(reason...);
+    return {bits, validity};
+  }
+  Span share() && { return std::move(*this); }
+  bool isShared() const { return true; }
+
+  /**
+   * see Span::getValidity
+   */
+  ValidityBitmap const& getValidity() const { return validity; }
+  bool isValid(size_t index) const { return validity.isValid(index); }
+  size_t nullCount() const { return validity.nullCount(); }
+  Span withValidity(ValidityBitmap validity) && {
+    if(validity.isPresent() && validity.size() != size()) {
+      throw std::invalid_argument("validity bitmap and span sizes differ");
+    }
+    this->validity = std::move(validity);
+    return std::move(*this);
+  }
+
+  friend std::ostream& operator<<(std::ostream& stream, Span const& span) {
+    return stream << span.size();
+  }
+};
+
+/**
+ * The element tag of selection views, see Span<Selected<Scalar>>
+ */
+template <typename Scalar> struct Selected {};
+
+/**
+ * A view of the rows of a span that survived a selection (late materialization): the base span and
+ * the indices of the selected rows, so columns that are filtered (but, e.g., only grouped on or
+ * projected away later) are not copied. The base is shared (a shared span can be wrapped by
+ * make_shared on a clone of it in constant time), and so are the indices, so clones and subspans of
+ * views are constant time. The elements are the base's (const) elements, materialize() copies them
+ * into a contiguous span when a consumer needs one.
+ */
+template <typename Scalar> struct Span<Selected<Scalar>> {
+  using Index = std::uint32_t;
+  using Base = std::shared_ptr<Span<Scalar> const>;
+  using Indices = std::shared_ptr<std::vector<Index> const>;
+
+private:
+  Base base;
+  Indices indices;
+  size_t first = 0;
+  size_t count = 0;
+  ValidityBitmap validity;
+
+public: // surface
+  using element_type = Scalar const;
+
+  class Iterator {
+    Span<Scalar> const* base = nullptr;
+    Index const* index = nullptr;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = Scalar;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Scalar const*;
+    using reference = Scalar const&;
+
+    Iterator() noexcept = default;
+    Iterator(Span<Scalar> const* base, Index const* index) : base(base), index(index) {}
+
+    Scalar const& operator*() const { return (*base)[*index]; }
+    Scalar const& operator[](difference_type n) const { return *(*this + n); }
+
+    Iterator& operator++() {
+      ++index;
+      return *this;
+    }
+    Iterator operator++(int) { return {base, index++}; }
+    Iterator& operator--() {
+      --index;
+      return *this;
+    }
+    Iterator operator--(int) { return {base, index--}; }
+    Iterator& operator+=(difference_type n) {
+      index += n;
+      return *this;
+    }
+    Iterator& operator-=(difference_type n) {
+      index -= n;
+      return *this;
+    }
+    friend Iterator operator+(Iterator it, difference_type n) { return it += n; }
+    friend Iterator operator+(difference_type n, Iterator it) { return it += n; }
+    friend Iterator operator-(Iterator it, difference_type n) { return it -= n; }
+    friend difference_type operator-(Iterator const& left, Iterator const& right) {
+      return left.index - right.index;
+    }
+    bool operator==(Iterator const& other) const { return index == other.index; }
+    bool operator!=(Iterator const& other) const { return index != other.index; }
+    bool operator<(Iterator const& other) const { return index < other.index; }
+    bool operator>(Iterator const& other) const { return index > other.index; }
+    bool operator<=(Iterator const& other) const { return index <= other.index; }
+    bool operator>=(Iterator const& other) const { return index >= other.index; }
+  };
+
+  size_t size() const { return count; }
+  Scalar const& operator[](size_t index) const { return (*base)[(*indices)[first + index]]; }
+  Scalar const& at(size_t index) const {
+    if(index < count) {
+      return (*this)[index];
+    }
+    throw std::out_of_range("Span has no element with index " + std::to_string(index));
+  }
+  Iterator begin() const { return {base.get(), indices->data() + first}; }
+  Iterator end() const { return {base.get(), indices->data() + first + count}; }
+
+  Span<Scalar> const& getBase() const { return *base; }
+  Index const* indexData() const { return indices->data() + first; }
+
+  /**
+   * copies the selected elements into a new (contiguous) span
+   */
+  Span<Scalar> materialize() const {
+    return Span<Scalar>(std::vector<Scalar>(begin(), end())).withValidity(validity);
+  }
+
+  Span subspan(size_t offset, size_t size) && {
+    first += offset;
+    count = size;
+    validity = validity.slice(offset, size);
+    return std::move(*this);
+  }
+  Span subspan(size_t offset) && { return std::move(*this).subspan(offset, count - offset); }
+
+  /**
+   * The indices of the rows that are true in the (word-packed boolean) selection, e.g., a predicate
+   * result. They can be shared by the views of all columns of a table. Throws std::length_error if
+   * the selection has more rows than an Index can address
+   */
+  static Indices indicesOf(Span<PackedBool> const& selection) {
+    if(selection.size() > std::numeric_limits<Index>::max()) {
+      throw std::length_error("a selection view cannot index more than 2^32 rows");
+    }
+    auto indices = std::vector<Index>();
+    indices.reserve(selection.popcount());
+    selection.forEachSetBit([&indices](size_t index) { indices.push_back(Index(index)); });
+    return std::make_shared<std::vector<Index> const>(std::move(indices));
+  }
+
+  /**
+   * The indices must be valid indices into the base (they are checked). Selected rows that are
+   * missing in the base are missing in the view
+   */
+  Span(Base base, Indices selection)
+      : base(std::move(base)), indices(std::move(selection)), count(indices->size()),
+        validity([this]() {
+          if(std::any_of(indices->begin(), indices->end(),
+                         [size = this->base->size()](Index index) { return index >= size; })) {
+            throw std::out_of_range("selection has an index beyond the end of the base span");
+          }
+          if(this->base->nullCount() == 0) {
+            return ValidityBitmap();
+          }
+          auto valid = std::vector<bool>(indices->size());
+          std::transform(indices->begin(), indices->end(), valid.begin(),
+                         [this](Index index) { return this->base->isValid(index); });
+          return ValidityBitmap(valid);
+        }()) {}
+
+  Span(Base base, std::vector<Index>&& selection)
+      : Span(std::move(base), std::make_shared<std::vector<Index> const>(std::move(selection))) {}
+  Span(Base base, Span<PackedBool> const& selection)
+      : Span(std::move(base), indicesOf(selection)) {}
+
+  bool operator==(Span const& other) const {
+    return base == other.base && indexData() == other.indexData() && count == other.count;
+  }
+
+  Span() noexcept = default;
+  Span(Span const& other) = delete;
+  Span(Span&& other) noexcept = default;
+  Span& operator=(Span&& other) noexcept = default;
+  Span& operator=(Span const&) = delete;
+  ~Span() = default;
+
+  /**
+   * see Span::clone -- the base and the indices are immutable, so they are always shared
+   */
+  template <typename... Reason> Span clone(Reason... reason) const& {
+    checkCloneWithoutReason(reason...);
+    auto result = Span();
+    result.base = base;
+    result.indices = indices;
+    result.first = first;
+    result.count = count;
+    result.validity = validity;
+    return result;
+  }
+  Span share() && { return std::move(*this); }
+  bool isShared() const { return true; }
+
+  /**
+   * see Span::getValidity
+   */
+  ValidityBitmap const& getValidity() const { return validity; }
+  bool isValid(size_t index) const { return validity.isValid(index); }
+  size_t nullCount() const { return validity.nullCount(); }
+  Span withValidity(ValidityBitmap validity) && {
+    if(validity.isPresent() && validity.size() != size()) {
+      throw std::invalid_argument("validity bitmap and span sizes differ");
+    }
+    this->validity = std::move(validity);
+    return std::move(*this);
+  }
+
+  friend std::ostream& operator<<(std::ostream& stream, Span const& span) {
+    return stream << span.size();
+  }
+};
+
+/**
+ * The element tag of compressed integer columns, see Span<Encoded<Integer>>
+ */
+template <typename Integer> struct Encoded {};
+
+/**
+ * The lightweight encodings of integer spans:
+ * - RunLength stores each run of equal values once (for sorted or clustered keys)
+ * - FrameOfReference stores, per block of values, the block minimum and the (bit-packed)
+ *   differences to it (for narrow-range values such as quantities or priorities)
+ * - Delta stores, per block, the first value and the (bit-packed) differences between consecutive
+ *   values (for sorted, dense keys)
+ */
+enum class Encoding : std::uint8_t { RunLength, FrameOfReference, Delta };
+
+/**
+ * A column of integers in one of the lightweight encodings (selected at construction). The encoded
+ * data is immutable, so clones (and subspans) share it. Elements are decoded on access (by value,
+ * so they cannot be modified) without unpacking their block, or a block at a time by decode (which
+ * is what visitChunks uses). Iterators remember the last element they decoded, so that iterating
+ * decodes each element incrementally (see Cursor).
+ */
+template <typename Integer> struct Span<Encoded<Integer>> {
+  using Word = std::uint64_t;
+  static constexpr size_t blockSize = 128;
+
+private:
+  using Unsigned = std::make_unsigned_t<Integer>;
+  static constexpr unsigned bitsPerWord = 64;
+
+  struct Block {
+    Unsigned reference;   // the minimum (frame of reference) or the first value (delta)
+    Unsigned deltaBase;   // the minimum difference between consecutive values (delta)
+    size_t firstWord;     // of the block's bit-packed values
+    std::uint8_t width;   // of the block's bit-packed values
+  };
+  struct Data {
+    Encoding encoding;
+    std::vector<Integer> runValues; // run-length
+    std::vector<size_t> runEnds;    // run-length, exclusive
+    std::vector<Block> blocks;      // frame-of-reference and delta
+    std::vector<Word> words;        // frame-of-reference and delta
+  };
+
+  std::shared_ptr<Data const> data;
+  size_t first = 0; // the offset of the span's first element in the encoded data
+  size_t count = 0;
+  ValidityBitmap validity;
+
+  static std::uint8_t bitWidth(Unsigned value) {
+    auto width = std::uint8_t(0);
+    for(; value != 0; value >>= 1U) {
+      width++;
+    }
+    return width;
+  }
+
+  /**
+   * Unpacks a block (adding the reference to every value). The width is a template argument and
+   * the values are unpacked by an unrolled sequence of statements (per group of 64 values, which
+   * take exactly width words), so all shifts and masks are constants. See unpackers for the
+   * dispatch on the width.
+   */
+  template <unsigned Width, size_t I> static Unsigned unpackValue(Word const* words) {
+    if constexpr(Width == 0) {
+      return 0;
+    } else {
+      constexpr auto shift = I * Width % bitsPerWord;
+      auto value = words[I * Width / bitsPerWord] >> shift;
+      if constexpr(shift + Width > bitsPerWord) {
+        value |= words[I * Width / bitsPerWord + 1] << (bitsPerWord - shift);
+      }
+      if constexpr(Width < bitsPerWord) {
+        value &= (Word(1) << Width) - 1;
+      }
+      return static_cast<Unsigned>(value);
+    }
+  }
+  template <unsigned Width, size_t... I>
+  static void unpackGroup(Word const* words, Unsigned reference, Integer* output,
+                          std::index_sequence<I...> /*unused*/) {
+    ((output[I] = Integer(Unsigned(reference + unpackValue<Width, I>(words)))), ...);
+  }
+  template <unsigned Width>
+  static void unpack(Word const* words, Unsigned reference, Integer* output) {
+    static_assert(blockSize % bitsPerWord == 0);
+    for(auto group = size_t(0); group < blockSize / bitsPerWord; group++) {
+      unpackGroup<Width>(words + group * Width, reference, output + group * bitsPerWord,
+                         std::make_index_sequence<bitsPerWord>());
+    }
+  }
+  using Unpacker = void (*)(Word const*, Unsigned, Integer*);
+  template <size_t... Widths>
+  static constexpr std::array<Unpacker, sizeof...(Widths)>
+  unpackers(std::index_sequence<Widths...> /*unused*/) {
+    return {&unpack<Widths>...};
+  }
+
+  /**
+   * appends the bit-packed block (each of the values needs at most width bits)
+   */
+  static void pack(std::vector<Word>& words, std::vector<Unsigned> const& values, unsigned width) {
+    auto const firstWord = words.size();
+    words.resize(firstWord + (values.size() * width + bitsPerWord - 1) / bitsPerWord);
+    for(auto i = size_t(0); width > 0 && i < values.size(); i++) {
+      auto const bit = i * width;
+      auto const shift = bit % bitsPerWord;
+      words[firstWord + bit / bitsPerWord] |= Word(values[i]) << shift;
+      if(shift + width > bitsPerWord) {
+        words[firstWord + bit / bitsPerWord + 1] |= Word(values[i]) >> (bitsPerWord - shift);
+      }
+    }
+  }
+
+  static std::shared_ptr<Data const> encode(std::vector<Integer> const& values,
+                                            Encoding encoding) {
+    auto data = Data{encoding, {}, {}, {}, {}};
+    if(encoding == Encoding::RunLength) {
+      for(auto i = size_t(0); i < values.size(); i++) {
+        if(data.runValues.empty() || values[i] != data.runValues.back()) {
+          data.runValues.push_back(values[i]);
+          data.runEnds.push_back(i);
+        }
+        data.runEnds.back() = i + 1;
+      }
+      return std::make_shared<Data const>(std::move(data));
+    }
+    auto packed = std::vector<Unsigned>();
+    for(auto blockBegin = size_t(0); blockBegin < values.size(); blockBegin += blockSize) {
+      auto const blockEnd = std::min(values.size(), blockBegin + blockSize);
+      auto block = Block{Unsigned(values[blockBegin]), 0, data.words.size(), 0};
+      packed.assign(blockSize, 0); // the last block is padded, blocks are unpacked as a whole
+      if(encoding == Encoding::FrameOfReference) {
+        block.reference = Unsigned(*std::min_element(values.begin() + blockBegin,
+                                                     values.begin() + blockEnd));
+        for(auto i = blockBegin; i < blockEnd; i++) {
+          packed[i - blockBegin] = Unsigned(Unsigned(values[i]) - block.reference);
+        }
+      } else {
+        auto const delta = [&values](size_t i) {
+          return Integer(Unsigned(Unsigned(values[i]) - Unsigned(values[i - 1])));
+        };
+        auto deltaBase = std::numeric_limits<Integer>::max();
+        for(auto i = blockBegin + 1; i < blockEnd; i++) {
+          deltaBase = std::min(deltaBase, delta(i));
+        }
+        block.deltaBase = Unsigned(deltaBase);
+        for(auto i = blockBegin + 1; i < blockEnd; i++) {
+          packed[i - blockBegin] = Unsigned(Unsigned(delta(i)) - block.deltaBase);
+        }
+      }
+      block.width = bitWidth(*std::max_element(packed.begin(), packed.end()));
+      pack(data.words, packed, block.width);
+      data.blocks.push_back(block);
+    }
+    return std::make_shared<Data const>(std::move(data));
+  }
+
+  /**
+   * the bit-packed value at the position (in the block), extracted without unpacking the block
+   */
+  Unsigned packedValue(Block const& block, size_t position) const {
+    if(block.width == 0) {
+      return 0;
+    }
+    auto const* words = data->words.data() + block.firstWord;
+    auto const bit = position * block.width;
+    auto const shift = bit % bitsPerWord;
+    auto value = words[bit / bitsPerWord] >> shift;
+    if(shift + block.width > bitsPerWord) {
+      value |= words[bit / bitsPerWord + 1] << (bitsPerWord - shift);
+    }
+    if(block.width < bitsPerWord) {
+      value &= (Word(1) << block.width) - 1;
+    }
+    return static_cast<Unsigned>(value);
+  }
+
+  /**
+   * The last decoded element (of the encoded data) and its run (run-length): its neighbours are
+   * decoded from it, without a search for the run or the prefix sum of the deltas before them
+   */
+  struct Cursor {
+    size_t index = std::numeric_limits<size_t>::max();
+    Integer value = 0;
+    size_t run = 0;
+  };
+
+  /**
+   * decodes the element at the index of the encoded data (not of the span), moving the cursor to it
+   */
+  Integer decodeValue(size_t index, Cursor& cursor) const {
+    if(index == cursor.index) {
+      return cursor.value;
+    }
+    auto const hasCursor = cursor.index != std::numeric_limits<size_t>::max();
+    auto const next = hasCursor && index == cursor.index + 1;
+    auto const previous = hasCursor && index + 1 == cursor.index;
+    auto const position = index % blockSize;
+    auto value = Unsigned(0);
+    if(data->encoding == Encoding::RunLength) {
+      if(next && index >= data->runEnds[cursor.run]) {
+        cursor.run++;
+      } else if(previous && cursor.run > 0 && index < data->runEnds[cursor.run - 1]) {
+        cursor.run--;
+      } else if(!next && !previous) {
+        cursor.run = size_t(std::upper_bound(data->runEnds.begin(), data->runEnds.end(), index) -
+                            data->runEnds.begin());
+      }
+      value = Unsigned(data->runValues[cursor.run]);
+    } else if(data->encoding == Encoding::FrameOfReference) {
+      auto const& block = data->blocks[index / blockSize];
+      value = Unsigned(block.reference + packedValue(block, position));
+    } else {
+      auto const& block = data->blocks[index / blockSize];
+      if(next && position != 0) {
+        value = Unsigned(Unsigned(cursor.value) + block.deltaBase + packedValue(block, position));
+      } else if(previous && position + 1 != blockSize) {
+        value = Unsigned(Unsigned(cursor.value) - block.deltaBase -
+                         packedValue(block, position + 1));
+      } else { // the first delta is 0
+        value = Unsigned(block.reference - block.deltaBase);
+        for(auto i = size_t(0); i <= position; i++) {
+          value += block.deltaBase + packedValue(block, i);
+        }
+      }
+    }
+    cursor.index = index;
+    cursor.value = Integer(value);
+    return cursor.value;
+  }
+
+  /**
+   * decodes the elements [begin, begin + n) of the encoded data (not of the span)
+   */
+  void decodeData(size_t begin, size_t n, Integer* output) const {
+    if(data->encoding == Encoding::RunLength) {
+      auto run = size_t(std::upper_bound(data->runEnds.begin(), data->runEnds.end(), begin) -
+                        data->runEnds.begin());
+      for(auto end = begin + n; begin < end; run++) {
+        auto const runLength = std::min(data->runEnds[run], end) - begin;
+        output = std::fill_n(output, runLength, data->runValues[run]);
+        begin += runLength;
+      }
+      return;
+    }
+    static constexpr auto unpackers =
+        Span::unpackers(std::make_index_sequence<sizeof(Unsigned) * CHAR_BIT + 1>());
+    std::array<Integer, blockSize> unpacked; // NOLINT(cppcoreguidelines-pro-type-member-init)
+    for(auto end = begin + n; begin < end;) {
+      auto const& block = data->blocks[begin / blockSize];
+      auto const blockBegin = begin / blockSize * blockSize;
+      auto const blockEnd = std::min(end, blockBegin + blockSize);
+      auto const* words = data->words.data() + block.firstWord;
+      if(data->encoding == Encoding::FrameOfReference) {
+        if(begin == blockBegin && blockEnd == blockBegin + blockSize) { // straight to the output
+          unpackers[block.width](words, block.reference, output);
+          output += blockSize;
+        } else {
+          unpackers[block.width](words, block.reference, unpacked.data());
+          output = std::copy(unpacked.begin() + (begin - blockBegin),
+                             unpacked.begin() + (blockEnd - blockBegin), output);
+        }
+      } else { // the deltas before the first requested value are needed, too
+        unpackers[block.width](words, 0, unpacked.data());
+        auto value = Unsigned(block.reference - block.deltaBase);
+        for(auto i = size_t(0); i < blockEnd - blockBegin; i++) {
+          value += block.deltaBase + Unsigned(unpacked[i]); // the first delta is 0
+          unpacked[i] = Integer(value);
+        }
+        output = std::copy(unpacked.begin() + (begin - blockBegin),
+                           unpacked.begin() + (blockEnd - blockBegin), output);
+      }
+      begin = blockEnd;
+    }
+  }
 
 public: // surface
-  using element_type = Scalar;
-  size_t size() const { return _end - _begin; }
-  constexpr auto operator[](size_t index) const -> decltype(auto) { return *(_begin + index); }
-  constexpr auto operator[](size_t index) -> decltype(auto) { return *(_begin + index); }
-  auto begin() const { return _begin; }
-  auto end() const { return _end; }
+  using element_type = Integer;
 
-  constexpr auto at(size_t index) const -> decltype(auto) {
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay,hicpp-no-array-decay)
-    if(_begin + index < _end) {
-      return (*this)[index];
+  class Iterator {
+    Span const* span = nullptr;
+    size_t index = 0;
+    mutable Cursor cursor;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = Integer;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Integer;
+
+    Iterator() noexcept = default;
+    Iterator(Span const* span, size_t index) : span(span), index(index) {}
+    Iterator(Span const* span, size_t index, Cursor const& cursor)
+        : span(span), index(index), cursor(cursor) {}
+
+    Integer operator*() const { return span->decodeValue(span->first + index, cursor); }
+    Integer operator[](difference_type n) const { return *(*this + n); }
+
+    Iterator& operator++() {
+      ++index;
+      return *this;
     }
-    throw std::out_of_range("Span has no element with index " + std::to_string(index));
+    Iterator operator++(int) { return {span, index++, cursor}; }
+    Iterator& operator--() {
+      --index;
+      return *this;
+    }
+    Iterator operator--(int) { return {span, index--, cursor}; }
+    Iterator& operator+=(difference_type n) {
+      index += n;
+      return *this;
+    }
+    Iterator& operator-=(difference_type n) {
+      index -= n;
+      return *this;
+    }
+    friend Iterator operator+(Iterator it, difference_type n) { return it += n; }
+    friend Iterator operator+(difference_type n, Iterator it) { return it += n; }
+    friend Iterator operator-(Iterator it, difference_type n) { return it -= n; }
+    friend difference_type operator-(Iterator const& left, Iterator const& right) {
+      return difference_type(left.index) - difference_type(right.index);
+    }
+    bool operator==(Iterator const& other) const { return index == other.index; }
+    bool operator!=(Iterator const& other) const { return index != other.index; }
+    bool operator<(Iterator const& other) const { return index < other.index; }
+    bool operator>(Iterator const& other) const { return index > other.index; }
+    bool operator<=(Iterator const& other) const { return index <= other.index; }
+    bool operator>=(Iterator const& other) const { return index >= other.index; }
+  };
+
+  size_t size() const { return count; }
+  Integer operator[](size_t index) const {
+    auto cursor = Cursor();
+    return decodeValue(first + index, cursor);
   }
-  constexpr auto at(size_t index) -> decltype(auto) {
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay,hicpp-no-array-decay)
-    if(_begin + index < _end) {
+  Integer at(size_t index) const {
+    if(index < count) {
       return (*this)[index];
     }
     throw std::out_of_range("Span has no element with index " + std::to_string(index));
   }
+  Iterator begin() const { return {this, 0}; }
+  Iterator end() const { return {this, count}; }
 
-  constexpr Span<Scalar> subspan(size_t offset, size_t size) && {
-    _begin += offset;
-    _end = _begin + size;
+  /**
+   * decodes the elements [begin, begin + n) into the output (this is much faster than decoding
+   * them one at a time, even by an iterator)
+   */
+  void decode(size_t begin, size_t n, Integer* output) const {
+    decodeData(first + begin, n, output);
+  }
+
+  Encoding getEncoding() const { return data->encoding; }
+
+  /**
+   * the number of bytes taken by the encoded data (of the whole column, subspans share it)
+   */
+  size_t encodedSize() const {
+    return data->runValues.size() * sizeof(Integer) + data->runEnds.size() * sizeof(size_t) +
+           data->blocks.size() * sizeof(Block) + data->words.size() * sizeof(Word);
+  }
+
+  Span subspan(size_t offset, size_t size) && {
+    first += offset;
+    count = size;
+    validity = validity.slice(offset, size);
     return std::move(*this);
   }
+  Span subspan(size_t offset) && { return std::move(*this).subspan(offset, count - offset); }
 
-  constexpr Span<Scalar> subspan(size_t offset) && {
-    return std::move(*this).subspan(offset, _end - _begin - offset);
+  Span(std::vector<Integer> const& values, Encoding encoding)
+      : data(encode(values, encoding)), count(values.size()) {}
+
+  bool operator==(Span const& other) const {
+    return data == other.data && first == other.first && count == other.count;
   }
 
+  Span() noexcept = default;
+  Span(Span const& other) = delete;
+  Span(Span&& other) noexcept = default;
+  Span& operator=(Span&& other) noexcept = default;
+  Span& operator=(Span const&) = delete;
+  ~Span() = default;
+
   /**
-   * The span takes ownership of the adaptee
+   * see Span::clone -- the encoded data is immutable, so it is always shared
    */
-  explicit Span(std::vector<std::remove_const_t<Scalar>>&& adaptee)
-      : _begin([&/* capturing context for immediate evaluation */]() {
-          if constexpr(std::is_same_v<Scalar, bool>) {
-            return adaptee.begin();
-          } else {
-            return adaptee.data();
-          }
-        }()),
-        _end(_begin + adaptee.size()), destructor([owner = std::move(adaptee)]() {}) {}
+  template <typename... Reason> Span clone(Reason... reason) const& {
+    checkCloneWithoutReason(reason...);
+    auto result = Span();
+    result.data = data;
+    result.first = first;
+    result.count = count;
+    result.validity = validity;
+    return result;
+  }
+  Span share() && { return std::move(*this); }
+  bool isShared() const { return true; }
 
   /**
-   * The span does not take ownership of the adaptee. The vector better not be modified while the
-   * span lives
+   * see Span::getValidity
    */
-  explicit Span(std::vector<std::remove_const_t<Scalar>>& adaptee)
-      : _begin([&adaptee]() {
-          if constexpr(std::is_same_v<Scalar, bool>) {
-            return adaptee.begin();
-          } else {
-            return adaptee.data();
-          }
-        }()),
-        _end(_begin + adaptee.size()) {}
+  ValidityBitmap const& getValidity() const { return validity; }
+  bool isValid(size_t index) const { return validity.isValid(index); }
+  size_t nullCount() const { return validity.nullCount(); }
+  Span withValidity(ValidityBitmap validity) && {
+    if(validity.isPresent() && validity.size() != size()) {
+      throw std::invalid_argument("validity bitmap and span sizes differ");
+    }
+    this->validity = std::move(validity);
+    return std::move(*this);
+  }
+
+  friend std::ostream& operator<<(std::ostream& stream, Span const& span) {
+    return stream << span.size();
+  }
+};
+/**
+ * The element tag of lazily produced columns, see Span<Generated<Scalar>>
+ */
+template <typename Scalar> struct Generated {};
 
+/**
+ * A column whose elements are not resident but produced on demand by a callback, e.g., one that
+ * reads from a file or pulls from an upstream operator. The producer writes the elements
+ * [begin, begin + n) of the column to the output. Only the size has to be known up front (span
+ * arguments are indexed): visitChunks pulls the column a block at a time, in order, through a
+ * single buffer, so memory is bounded by the block size however long the column. Elements are
+ * produced on access (by value, one at a time -- bulk consumers should use produce or
+ * visitChunks), materialize() produces all of them into a contiguous span. The producer is
+ * shared, so clones and subspans are constant time. The parallel algorithms (see
+ * boss::algorithm::parallelAccumulate) call it from several threads at once, so it has to be
+ * thread-safe (sequential sources are not, see isSequential).
+ */
+template <typename Scalar> struct Span<Generated<Scalar>> {
+  using Producer = std::function<void(size_t begin, size_t n, Scalar* output)>;
   /**
-   * The span does not take ownership of the adaptee. The vector better not be modified while the
-   * span lives
+   * a sequential source: writes (at most n of) its next elements to the output and returns how
+   * many it wrote (0 at the end of its data)
    */
-  explicit Span(std::vector<std::remove_const_t<Scalar>> const& adaptee)
-      : _begin([&adaptee]() {
-          if constexpr(std::is_same_v<Scalar, bool>) {
-            return adaptee.begin();
-          } else {
-            return adaptee.data();
-          }
-        }()),
-        _end(_begin + adaptee.size()) {}
+  using Source = std::function<size_t(Scalar* output, size_t n)>;
 
-  explicit Span(IteratorType begin, size_t size, std::function<void(void)> destructor)
-      : _begin(begin), _end(begin + size), destructor(std::move(destructor)) {}
+private:
+  std::shared_ptr<Producer const> producer;
+  size_t first = 0; // the offset of the span's first element in the produced column
+  size_t count = 0;
+  bool sequentialSource = false;
+  ValidityBitmap validity;
 
-  bool operator==(Span const& other) const { return _begin == other._begin; }
+public: // surface
+  using element_type = Scalar;
 
-  Span() noexcept = default;
+  class Iterator {
+    Span const* span = nullptr;
+    size_t index = 0;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = Scalar;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Scalar;
+
+    Iterator() noexcept = default;
+    Iterator(Span const* span, size_t index) : span(span), index(index) {}
+
+    Scalar operator*() const { return (*span)[index]; }
+    Scalar operator[](difference_type n) const { return *(*this + n); }
+
+    Iterator& operator++() {
+      ++index;
+      return *this;
+    }
+    Iterator operator++(int) { return {span, index++}; }
+    Iterator& operator--() {
+      --index;
+      return *this;
+    }
+    Iterator operator--(int) { return {span, index--}; }
+    Iterator& operator+=(difference_type n) {
+      index += n;
+      return *this;
+    }
+    Iterator& operator-=(difference_type n) {
+      index -= n;
+      return *this;
+    }
+    friend Iterator operator+(Iterator it, difference_type n) { return it += n; }
+    friend Iterator operator+(difference_type n, Iterator it) { return it += n; }
+    friend Iterator operator-(Iterator it, difference_type n) { return it -= n; }
+    friend difference_type operator-(Iterator const& left, Iterator const& right) {
+      return difference_type(left.index) - difference_type(right.index);
+    }
+    bool operator==(Iterator const& other) const { return index == other.index; }
+    bool operator!=(Iterator const& other) const { return index != other.index; }
+    bool operator<(Iterator const& other) const { return index < other.index; }
+    bool operator>(Iterator const& other) const { return index > other.index; }
+    bool operator<=(Iterator const& other) const { return index <= other.index; }
+    bool operator>=(Iterator const& other) const { return index >= other.index; }
+  };
+
+  size_t size() const { return count; }
+  Scalar operator[](size_t index) const {
+    auto value = Scalar();
+    produce(index, 1, &value);
+    return value;
+  }
+  Scalar at(size_t index) const {
+    if(index < count) {
+      return (*this)[index];
+    }
+    throw std::out_of_range("Span has no element with index " + std::to_string(index));
+  }
+  Iterator begin() const { return {this, 0}; }
+  Iterator end() const { return {this, count}; }
 
   /**
-   * We consider Spans move-only because they can be *really* expensive to copy. It you really,
-   * really have to copy one, use the clone() function and provide a reason
+   * produces the elements [begin, begin + n) into the output
    */
-  Span(Span const& other) = delete;
-  Span(Span&& other) noexcept
-      : _begin(other._begin), _end(other._end), destructor(std::move(other.destructor)) {
-    other.destructor = nullptr;
-  };
+  void produce(size_t begin, size_t n, Scalar* output) const {
+    if(n > 0) {
+      (*producer)(first + begin, n, output);
+    }
+  }
 
   /**
-   * because the Span constructor cannot infer what data structure/payload was used to hold the
-   * values in the other Span, arguments are copied into a std::vector. The alternative would be
-   * to use some kind of reference chain or counting but I (Holger) did not like that -- I am open
-   * to discussing this, though
+   * produces all elements into a new (contiguous) span
    */
-  template <typename... Reason> Span<std::remove_const_t<Scalar>> clone(Reason... reason) const& {
-    checkCloneWithoutReason(reason...);
-    return Span<std::remove_const_t<Scalar>>(
-        std::vector<std::remove_const_t<Scalar>>(_begin, _end));
+  Span<Scalar> materialize() const {
+    auto values = std::vector<Scalar>(count);
+    produce(0, count, values.data());
+    return Span<Scalar>(std::move(values)).withValidity(validity);
   }
 
-  Span& operator=(Span&& other) noexcept {
-    _begin = (other._begin);
-    _end = (other._end);
-    destructor = (std::move(other.destructor));
-    other.destructor = nullptr;
-    return *this;
-  };
+  Span subspan(size_t offset, size_t size) && {
+    first += offset;
+    count = size;
+    validity = validity.slice(offset, size);
+    return std::move(*this);
+  }
+  Span subspan(size_t offset) && { return std::move(*this).subspan(offset, count - offset); }
+
+  Span(size_t size, Producer producer)
+      : producer(std::make_shared<Producer const>(std::move(producer))), count(size) {}
 
   /**
-   * see comment on the copy constructor about copying Spans
+   * Adapts a sequential source. Its elements can only be produced in order: skipped elements are
+   * read and dropped, going back throws a std::logic_error (so a sequential span can be visited
+   * once -- materialize it to visit it again). A source that ends early throws a
+   * std::runtime_error
+   */
+  static Span sequential(size_t size, Source source) {
+    auto result = Span(size, [source = std::move(source), position = size_t(0)](
+                          size_t begin, size_t n, Scalar* output) mutable {
+      if(begin < position) {
+        throw std::logic_error("the elements of a sequential span can only be produced in order");
+      }
+      auto const pull = [&source](Scalar* target, size_t elements) {
+        for(auto produced = size_t(0); produced < elements;) {
+          auto const sourced = source(target + produced, elements - produced);
+          if(sourced == 0) {
+            throw std::runtime_error("the source of a sequential span ended early");
+          }
+          produced += sourced;
+        }
+      };
+      auto skipped = std::vector<Scalar>(begin - position);
+      pull(skipped.data(), skipped.size());
+      pull(output, n);
+      position = begin + n;
+    });
+    result.sequentialSource = true;
+    return result;
+  }
+
+  /**
+   * whether the elements can only be produced in order (see sequential)
    */
+  bool isSequential() const { return sequentialSource; }
+
+  bool operator==(Span const& other) const {
+    return producer == other.producer && first == other.first && count == other.count;
+  }
+
+  /**
+   * whether the element index of this span is the element otherIndex of the other, i.e., the
+   * same element of the same produced column. Expressions compare and hash generated elements
+   * this way (see elementHash): producing them could consume a sequential source
+   */
+  bool producesSameElement(size_t index, Span const& other, size_t otherIndex) const {
+    return producer == other.producer && first + index == other.first + otherIndex;
+  }
+  std::size_t elementHash(size_t index) const {
+    return boss::utilities::hashCombine(std::hash<Producer const*>{}(producer.get()),
+                                        first + index);
+  }
+
+  Span() noexcept = default;
+  Span(Span const& other) = delete;
+  Span(Span&& other) noexcept = default;
+  Span& operator=(Span&& other) noexcept = default;
   Span& operator=(Span const&) = delete;
-  // NOLINTBEGIN(bugprone-exception-escape)
+  ~Span() = default;
+
+  /**
+   * see Span::clone -- clones share the producer (a sequential source, too: it is not restarted)
+   */
+  template <typename... Reason> Span clone(Reason... reason) const& {
+    checkCloneWithoutReason(reason...);
+    auto result = Span();
+    result.producer = producer;
+    result.first = first;
+    result.count = count;
+    result.sequentialSource = sequentialSource;
+    result.validity = validity;
+    return result;
+  }
+  Span share() && { return std::move(*this); }
+  bool isShared() const { return true; }
 
-  ~Span() {
-    if(destructor) {
-      destructor();
+  /**
+   * see Span::getValidity
+   */
+  ValidityBitmap const& getValidity() const { return validity; }
+  bool isValid(size_t index) const { return validity.isValid(index); }
+  size_t nullCount() const { return validity.nullCount(); }
+  Span withValidity(ValidityBitmap validity) && {
+    if(validity.isPresent() && validity.size() != size()) {
+      throw std::invalid_argument("validity bitmap and span sizes differ");
     }
-  };
-  // NOLINTEND(bugprone-exception-escape)
+    this->validity = std::move(validity);
+    return std::move(*this);
+  }
 
   friend std::ostream& operator<<(std::ostream& stream, Span const& span) {
-    return stream << span.size;
+    return stream << span.size();
   }
 };
 } // namespace atoms
+using atoms::Bitmap;
+using atoms::Date;
+using atoms::Decimal;
+using atoms::DictionaryEncoded;
+using atoms::Encoded;
+using atoms::Encoding;
+using atoms::Generated;
+using atoms::PackedBool;
+using atoms::Selected;
 using atoms::Span;
 using atoms::Symbol;
+using atoms::ValidityBitmap;
 
 template <typename TargetType> class ArgumentTypeMismatch;
 template <> class ArgumentTypeMismatch<void> : public ::std::bad_variant_access {
@@ -226,7 +2347,9 @@ public:
                                                          {typeid(float_t), "float"},
                                                          {typeid(double_t), "double"},
                                                          {typeid(::std::string), "string"},
-                                                         {typeid(Symbol), "Symbol"}};
+                                                         {typeid(Symbol), "Symbol"},
+                                                         {typeid(Date), "Date"},
+                                                         {typeid(Decimal), "Decimal"}};
           output << "\", expected "
                  << (typenames.count(typeid(TargetType)) ? typenames.at(typeid(TargetType))
                                                          : typeid(TargetType).name());
@@ -237,7 +2360,7 @@ public:
 template <typename... AdditionalCustomAtoms>
 using AtomicExpressionWithAdditionalCustomAtoms =
     std::variant<bool, std::int8_t, std::int32_t, std::int64_t, std::float_t, std::double_t,
-                 std::string, Symbol, AdditionalCustomAtoms...>;
+                 std::string, Symbol, Date, Decimal, AdditionalCustomAtoms...>;
 
 namespace generic {
 
@@ -248,6 +2371,91 @@ inline constexpr bool isComplexExpression =
     boss::utilities::isInstanceOfTemplate<std::decay_t<T>,
                                           ComplexExpressionWithAdditionalCustomAtoms>::value;
 
+/**
+ * The hash of an atom: numbers are hashed by value (so the hash does not depend on the width they
+ * happen to be stored with), everything else is tagged with its type so that, e.g., a string and a
+ * symbol with the same name do not collide. Atoms without a std::hash are only told apart by type.
+ * String views (the elements of string spans) hash like the strings they compare equal to.
+ */
+template <typename T> std::size_t hashAtom(T const& value) {
+  if constexpr(std::is_arithmetic_v<T>) {
+    auto const canonical = static_cast<double_t>(value);
+    return std::hash<double_t>{}(canonical == 0 ? 0.0 : canonical); // -0.0 == 0.0
+  } else if constexpr(std::is_same_v<T, std::string_view>) {
+    static auto const typeHash = std::type_index(typeid(std::string)).hash_code();
+    return boss::utilities::hashCombine(typeHash, std::hash<std::string_view>{}(value));
+  } else {
+    static auto const typeHash = std::type_index(typeid(T)).hash_code();
+    if constexpr(boss::utilities::is_hashable<T>::value) {
+      return boss::utilities::hashCombine(typeHash, std::hash<T>{}(value));
+    } else {
+      return typeHash;
+    }
+  }
+}
+
+/**
+ * A lazily computed hash (zero meaning "not computed yet"). It moves with the value it belongs to
+ * and has to be reset by the owner whenever it hands out mutable access to that value. Mutable
+ * access that outlives the call handing it out (e.g., an argument wrapper) borrows the cache
+ * instead: while it is borrowed, hashes are computed but not cached, and it is reset when the
+ * last borrow ends.
+ */
+class CachedHash {
+  mutable std::atomic<std::size_t> value{0};
+  std::atomic<std::size_t> borrows{0};
+
+public:
+  CachedHash() = default;
+  CachedHash(CachedHash&& other) noexcept
+      : value(other.value.exchange(0, std::memory_order_relaxed)) {}
+  CachedHash& operator=(CachedHash&& other) noexcept {
+    value.store(other.value.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    return *this;
+  }
+  CachedHash(CachedHash const&) = delete;
+  CachedHash& operator=(CachedHash const&) = delete;
+  ~CachedHash() = default;
+
+  template <typename Compute> std::size_t get(Compute&& compute) const {
+    auto result = value.load(std::memory_order_relaxed);
+    if(result == 0) {
+      result = std::max<std::size_t>(std::forward<Compute>(compute)(), 1);
+      if(borrows.load(std::memory_order_relaxed) == 0) {
+        value.store(result, std::memory_order_relaxed);
+      }
+    }
+    return result;
+  }
+  std::size_t peek() const { return value.load(std::memory_order_relaxed); }
+  void reset() { value.store(0, std::memory_order_relaxed); }
+
+  /**
+   * Keeps the cache empty for as long as it lives (a null borrow does nothing)
+   */
+  class Borrow {
+    CachedHash* cache;
+
+  public:
+    explicit Borrow(CachedHash* cache = nullptr) : cache(cache) {
+      if(cache != nullptr) {
+        cache->borrows.fetch_add(1, std::memory_order_relaxed);
+        cache->reset();
+      }
+    }
+    Borrow(Borrow const& other) : Borrow(other.cache) {}
+    Borrow(Borrow&& other) noexcept : cache(std::exchange(other.cache, nullptr)) {}
+    Borrow& operator=(Borrow const&) = delete;
+    Borrow& operator=(Borrow&&) = delete;
+    ~Borrow() {
+      if(cache != nullptr) {
+        cache->reset();
+        cache->borrows.fetch_sub(1, std::memory_order_relaxed);
+      }
+    }
+  };
+};
+
 template <typename... AdditionalCustomAtoms>
 class ExpressionWithAdditionalCustomAtoms
     : public boss::utilities::variant_amend<
@@ -324,6 +2532,13 @@ public:
     }
     return std::get<T>(*this) == other;
   }
+  /**
+   * strings compare equal to the views handed out by string spans (see Span<std::string_view>)
+   */
+  template <typename T>
+  std::enable_if_t<std::is_same_v<T, std::string_view>, bool> operator==(T const& other) const {
+    return std::holds_alternative<std::string>(*this) && std::get<std::string>(*this) == other;
+  }
   template <typename T>
   std::enable_if_t<!std::is_same_v<T, ExpressionWithAdditionalCustomAtoms>, bool>
   operator!=(T const& other) const {
@@ -336,11 +2551,50 @@ public:
         ComplexExpressionWithAdditionalCustomAtoms<std::tuple<>, AdditionalCustomAtoms...>;
     return std::visit(
         boss::utilities::overload(
-            [](auto const& val) -> ExpressionWithAdditionalCustomAtoms { return val; },
-            [reason...](ComplexExpression const& val) -> ExpressionWithAdditionalCustomAtoms {
-              return ComplexExpression(val.clone(reason...));
+            [](auto const& val) -> ExpressionWithAdditionalCustomAtoms { return val; },
+            [reason...](ComplexExpression const& val) -> ExpressionWithAdditionalCustomAtoms {
+              return ComplexExpression(val.clone(reason...));
+            }),
+        (ExpressionWithAdditionalCustomAtoms::SuperType const&)*this);
+  }
+
+  /**
+   * see ComplexExpression::share -- atoms are returned as they are
+   */
+  ExpressionWithAdditionalCustomAtoms share() && {
+    using ComplexExpression =
+        ComplexExpressionWithAdditionalCustomAtoms<std::tuple<>, AdditionalCustomAtoms...>;
+    return std::visit(
+        boss::utilities::overload(
+            [](auto&& val) -> ExpressionWithAdditionalCustomAtoms { return std::move(val); },
+            [](ComplexExpression&& val) -> ExpressionWithAdditionalCustomAtoms {
+              return std::move(val).share();
+            }),
+        (ExpressionWithAdditionalCustomAtoms::SuperType&&)std::move(*this));
+  }
+
+  std::size_t hash() const {
+    return std::visit(
+        [](auto const& value) -> std::size_t {
+          if constexpr(isComplexExpression<decltype(value)>) {
+            return value.hash();
+          } else {
+            return hashAtom(value);
+          }
+        },
+        (ExpressionWithAdditionalCustomAtoms::SuperType const&)*this);
+  }
+
+  ExpressionWithAdditionalCustomAtoms relocate() && {
+    using ComplexExpression =
+        ComplexExpressionWithAdditionalCustomAtoms<std::tuple<>, AdditionalCustomAtoms...>;
+    return std::visit(
+        boss::utilities::overload(
+            [](auto&& val) -> ExpressionWithAdditionalCustomAtoms { return std::move(val); },
+            [](ComplexExpression&& val) -> ExpressionWithAdditionalCustomAtoms {
+              return std::move(val).relocate();
             }),
-        (ExpressionWithAdditionalCustomAtoms::SuperType const&)*this);
+        (ExpressionWithAdditionalCustomAtoms::SuperType&&)std::move(*this));
   }
 
   friend ::std::ostream& operator<<(::std::ostream& out,
@@ -356,10 +2610,16 @@ public:
 
 template <typename... AdditionalCustomAtoms>
 class ExpressionArgumentsWithAdditionalCustomAtoms
-    : public std::vector<ExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...>> {
+    : public std::vector<
+          ExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...>,
+          ExpressionAllocator<ExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...>>> {
+  using Vector = std::vector<
+      ExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...>,
+      ExpressionAllocator<ExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...>>>;
+
 public:
   ExpressionArgumentsWithAdditionalCustomAtoms() = default;
-  using std::vector<ExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...>>::vector;
+  using Vector::vector;
 
   template <typename... ArgType,
             std::enable_if_t<(std::is_convertible_v<ArgType, ExpressionWithAdditionalCustomAtoms<
@@ -367,29 +2627,40 @@ public:
                               ...),
                              bool> = false>
   explicit ExpressionArgumentsWithAdditionalCustomAtoms(ArgType&&... arg) {
-
-    (std::vector<ExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...>>::emplace_back(
-         std::move(arg)),
-     ...);
+    Vector::reserve(sizeof...(ArgType));
+    (Vector::emplace_back(std::move(arg)), ...);
   }
 };
 
 template <typename... AdditionalCustomAtoms>
 using ExpressionSpanArgumentWithAdditionalCustomAtoms =
     std::variant<Span<bool>, Span<std::int8_t>, Span<std::int32_t>, Span<std::int64_t>,
-                 Span<std::float_t>, Span<std::double_t>, Span<std::string>, Span<Symbol>,
-                 Span<AdditionalCustomAtoms>..., Span<bool const>, Span<std::int8_t const>,
-                 Span<std::int32_t const>, Span<std::int64_t const>, Span<std::float_t const>,
-                 Span<std::double_t const>, Span<std::string const>, Span<Symbol const>,
+                 Span<std::float_t>, Span<std::double_t>, Span<std::string>,
+                 Span<std::string_view>, Span<DictionaryEncoded>, Span<Encoded<std::int32_t>>,
+                 Span<Encoded<std::int64_t>>, Span<PackedBool>, Span<Selected<std::int32_t>>,
+                 Span<Selected<std::int64_t>>, Span<Selected<std::double_t>>,
+                 Span<Selected<std::string>>, Span<Selected<Date>>, Span<Selected<Decimal>>,
+                 Span<Generated<std::int64_t>>,
+                 Span<Generated<std::double_t>>, Span<Symbol>, Span<Date>, Span<Decimal>,
+                 Span<AdditionalCustomAtoms>..., Span<bool const>,
+                 Span<std::int8_t const>, Span<std::int32_t const>, Span<std::int64_t const>,
+                 Span<std::float_t const>, Span<std::double_t const>, Span<std::string const>,
+                 Span<Symbol const>, Span<Date const>, Span<Decimal const>,
                  Span<AdditionalCustomAtoms const>...>;
 
 template <typename... AdditionalCustomAtoms>
 class ExpressionSpanArgumentsWithAdditionalCustomAtoms
     : public std::vector<
-          ExpressionSpanArgumentWithAdditionalCustomAtoms<AdditionalCustomAtoms...>> {
+          ExpressionSpanArgumentWithAdditionalCustomAtoms<AdditionalCustomAtoms...>,
+          ExpressionAllocator<
+              ExpressionSpanArgumentWithAdditionalCustomAtoms<AdditionalCustomAtoms...>>> {
+  using Vector = std::vector<
+      ExpressionSpanArgumentWithAdditionalCustomAtoms<AdditionalCustomAtoms...>,
+      ExpressionAllocator<
+          ExpressionSpanArgumentWithAdditionalCustomAtoms<AdditionalCustomAtoms...>>>;
+
 public:
-  using std::vector<
-      ExpressionSpanArgumentWithAdditionalCustomAtoms<AdditionalCustomAtoms...>>::vector;
+  using Vector::vector;
 
   template <typename... ArgType,
             std::enable_if_t<
@@ -398,10 +2669,8 @@ public:
                  ...),
                 bool> = false>
   explicit ExpressionSpanArgumentsWithAdditionalCustomAtoms(ArgType&&... arg) {
-
-    (std::vector<ExpressionSpanArgumentWithAdditionalCustomAtoms<AdditionalCustomAtoms...>>::
-         emplace_back(std::move(arg)),
-     ...);
+    Vector::reserve(sizeof...(ArgType));
+    (Vector::emplace_back(std::move(arg)), ...);
   }
 
   // The Spans are not copyable anyway,
@@ -420,6 +2689,13 @@ public:
   ~ExpressionSpanArgumentsWithAdditionalCustomAtoms() = default;
 };
 
+/**
+ * Prefix sums over the sizes of an expression's span arguments: span i covers the (span-relative)
+ * offsets [offsets[i], offsets[i + 1]) and back() is the total number of span elements. Empty if
+ * there are no span arguments.
+ */
+using ExpressionSpanOffsets = std::vector<size_t, ExpressionAllocator<size_t>>;
+
 /**
  * MovableReferenceWrapper is a re-implementation of std::reference_wrapper
  * but which allows moving the stored reference with 'operator T&&() &&' and 'get() &&'.
@@ -472,12 +2748,26 @@ operator==(T const& left, MovableReferenceWrapper<T2> other) {
 }
 
 template <bool ConstWrappee = false, typename... AdditionalCustomAtoms> class ArgumentWrapper;
+
+/**
+ * Argument wrappers wrap references, except for the elements of spans that do not store them as
+ * such: the views into string spans, the decoded elements of encoded (and word-packed boolean)
+ * spans and the produced elements of generated spans are held by value. The elements of const bool
+ * spans are, too (std::vector<bool>'s const_reference is bool), so the const wrappee type has a
+ * bool alternative already
+ */
+template <typename T>
+inline constexpr bool isWrappedByValue = std::is_same_v<std::decay_t<T>, std::string_view> ||
+                                         std::is_same_v<std::decay_t<T>, std::int32_t> ||
+                                         std::is_same_v<std::decay_t<T>, std::int64_t> ||
+                                         std::is_same_v<std::decay_t<T>, std::double_t> ||
+                                         std::is_same_v<std::decay_t<T>, bool>;
 template <typename... AdditionalCustomAtoms>
 using ArgumentWrappeeType = typename boss::utilities::variant_amend<
     typename boss::utilities::rewrap_variant_arguments<
         MovableReferenceWrapper,
         AtomicExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...>>::type,
-    std::vector<bool>::reference,
+    std::vector<bool>::reference, std::string_view, std::int32_t, std::int64_t, std::double_t, bool,
     MovableReferenceWrapper<ExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...>>>::type;
 
 template <typename... AdditionalCustomAtoms>
@@ -486,7 +2776,7 @@ using ConstArgumentWrappeeType = typename boss::utilities::variant_amend<
         MovableReferenceWrapper,
         typename utilities::make_variant_members_const<
             AtomicExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...>>::type>::type,
-    std::vector<bool>::const_reference,
+    std::vector<bool>::const_reference, std::string_view, std::int32_t, std::int64_t, std::double_t,
     MovableReferenceWrapper<ExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...> const>>::
     type;
 
@@ -540,6 +2830,9 @@ public:
                                   ::std::is_same<::std::decay_t<decltype(expression)>,
                                                  ::std::vector<bool>::const_reference>>) {
             return (bool)expression;
+          } else if constexpr(::std::is_same_v<::std::decay_t<decltype(expression)>,
+                                               ::std::string_view>) {
+            return ::std::string(expression);
           } else {
             return std::forward<decltype(expression)>(expression);
           }
@@ -579,6 +2872,21 @@ public:
           }
         }()) {}
 
+  /**
+   * the elements of string spans (see Span<std::string_view>) are wrapped by value
+   */
+  ArgumentWrapper(std::string_view argument) // NOLINT(hicpp-explicit-conversions)
+      : argument(argument) {}
+
+  /**
+   * the decoded elements of encoded spans (see Span<Encoded<Integer>> and Span<PackedBool>) and the
+   * produced elements of generated spans (see Span<Generated<Scalar>>) are wrapped by value (the
+   * tag keeps references to numbers and bools from binding here)
+   */
+  template <typename T, typename = std::enable_if_t<isWrappedByValue<T>>>
+  ArgumentWrapper(std::in_place_type_t<T> byValue, T argument)
+      : argument(byValue, argument) {}
+
   bool valueless_by_exception() const { return argument.valueless_by_exception(); }
 
   auto at(size_t index) {
@@ -607,6 +2915,8 @@ public:
                                   std::decay_t<decltype(typedArg)>,
                                   MovableReferenceWrapper>::value) {
             return unwrap(typedArg.get());
+          } else if constexpr(std::is_same_v<std::decay_t<decltype(typedArg)>, std::string_view>) {
+            return std::string(typedArg);
           } else {
             return ExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...>(typedArg);
           }
@@ -636,6 +2946,8 @@ public:
                                             ::std::is_same<::std::decay_t<decltype(val)>,
                                                            ::std::vector<bool>::const_reference>>) {
             return stream << (bool)val;
+          } else if constexpr(isWrappedByValue<decltype(val)>) {
+            return stream << val;
           } else {
             return stream << val.get();
           }
@@ -719,19 +3031,93 @@ class ExpressionArgumentsWithAdditionalCustomAtomsWrapper {
                          ExpressionSpanArgumentsWithAdditionalCustomAtoms<AdditionalAtoms...> const,
                          ExpressionSpanArgumentsWithAdditionalCustomAtoms<AdditionalAtoms...>>;
   SpanArgumentsContainer& spanArguments;
+  ExpressionSpanOffsets const& spanOffsets;
+  /**
+   * the owner's hash is not cached while its arguments can be written through this wrapper
+   */
+  CachedHash::Borrow borrowedHash;
+
+  /**
+   * finds the span argument holding a (span-relative) offset: the hinted span and its successor
+   * are checked first (so that sequential access takes constant time), otherwise this falls back
+   * to a binary search over the span offsets
+   */
+  size_t findSpanArgument(size_t offset, size_t hint) const {
+    if(hint + 1 < spanOffsets.size() && spanOffsets[hint] <= offset) {
+      if(offset < spanOffsets[hint + 1]) {
+        return hint;
+      }
+      if(hint + 2 < spanOffsets.size() && offset < spanOffsets[hint + 2]) {
+        return hint + 1;
+      }
+    }
+    return std::upper_bound(spanOffsets.begin(), spanOffsets.end(), offset) - spanOffsets.begin() -
+           1;
+  }
+
+  ArgumentWrapper<IsConstWrapper, AdditionalAtoms...> getSpanArgument(size_t index,
+                                                                      size_t& spanHint) const {
+    auto const firstSpanIndex = std::tuple_size_v<StaticArgumentsContainer> + arguments.size();
+    if(index < firstSpanIndex || spanOffsets.empty() ||
+       index - firstSpanIndex >= spanOffsets.back()) {
+      throw std::out_of_range("Expression has no argument with index " + std::to_string(index));
+    }
+    auto const offset = index - firstSpanIndex;
+    spanHint = findSpanArgument(offset, spanHint);
+    return std::visit(
+        [offsetInSpan = offset - spanOffsets[spanHint]](
+            auto&& spanArgument) -> ArgumentWrapper<IsConstWrapper, AdditionalAtoms...> {
+          using Element = decltype(spanArgument[0]);
+          if constexpr(std::is_same_v<Element, std::int32_t> ||
+                       std::is_same_v<Element, std::int64_t> ||
+                       std::is_same_v<Element, std::double_t> ||
+                       std::is_same_v<std::decay_t<decltype(spanArgument)>, Span<PackedBool>>) {
+            return {std::in_place_type<Element>, spanArgument[offsetInSpan]}; // decoded elements
+          } else if constexpr(!IsConstWrapper &&
+                       (std::is_same_v<std::decay_t<Element>, std::vector<bool>::const_reference> ||
+                        std::is_const_v<std::remove_reference_t<decltype(spanArgument)>> ||
+                        std::is_const_v<std::remove_reference_t<Element>>)) {
+            throw std::runtime_error("cannot convert const span to non-const argument");
+          } else if constexpr(std::is_same_v<std::decay_t<Element>, std::vector<bool>::reference> ||
+                              std::is_same_v<std::decay_t<Element>,
+                                             std::vector<bool>::const_reference>) {
+            if constexpr(IsConstWrapper || std::is_same_v<std::decay_t<Element>,
+                                                          std::vector<bool>::const_reference>) {
+              return std::vector<bool>::const_reference(spanArgument[offsetInSpan]);
+            } else {
+              return std::vector<bool>::reference(spanArgument[offsetInSpan]);
+            }
+          } else {
+            return spanArgument[offsetInSpan];
+          }
+        },
+        spanArguments[spanHint]);
+  }
+
+  ArgumentWrapper<IsConstWrapper, AdditionalAtoms...> at(size_t index, size_t& spanHint) const {
+    if constexpr((std::tuple_size_v<StaticArgumentsContainer>) > 0) {
+      if(index < std::tuple_size_v<StaticArgumentsContainer>) {
+        return getStaticArgument(index);
+      }
+    }
+    if((index - std::tuple_size_v<StaticArgumentsContainer>) < arguments.size()) {
+      return arguments[index - std::tuple_size_v<StaticArgumentsContainer>];
+    }
+    return getSpanArgument(index, spanHint);
+  }
 
 public:
   ExpressionArgumentsWithAdditionalCustomAtomsWrapper(StaticArgumentsContainer& staticArguments,
                                                       DynamicArgumentsContainer& arguments,
-                                                      SpanArgumentsContainer& spanArguments)
-      : staticArguments(staticArguments), arguments(arguments), spanArguments(spanArguments) {}
+                                                      SpanArgumentsContainer& spanArguments,
+                                                      ExpressionSpanOffsets const& spanOffsets,
+                                                      CachedHash* cachedHash = nullptr)
+      : staticArguments(staticArguments), arguments(arguments), spanArguments(spanArguments),
+        spanOffsets(spanOffsets), borrowedHash(cachedHash) {}
 
   size_t size() const {
     return std::tuple_size_v<StaticArgumentsContainer> + arguments.size() +
-           std::accumulate(
-               spanArguments.begin(), spanArguments.end(), 0, [](auto soFar, auto& thisOne) {
-                 return soFar + std::visit([](auto&& thisOne) { return thisOne.size(); }, thisOne);
-               });
+           (spanOffsets.empty() ? 0 : spanOffsets.back());
   }
   bool empty() const { return size() == 0; }
 
@@ -746,6 +3132,7 @@ public:
                        ExpressionArgumentsWithAdditionalCustomAtomsWrapper>
         container;
     size_t index;
+    mutable size_t spanHint = 0; // the span argument that was accessed last
     Iterator next() const {
       auto result = *this;
       result++;
@@ -781,7 +3168,7 @@ public:
     std::ptrdiff_t operator-(Iterator const& other) const { return index - other.index; }
 
     ArgumentWrapper<IsConstIterator, AdditionalAtoms...> operator*() const {
-      return container.at(index);
+      return container.at(index, spanHint);
     }
     bool operator==(Iterator const& other) const { return index == other.index; }
     bool operator!=(Iterator const& other) const { return index != other.index; }
@@ -794,9 +3181,11 @@ public:
         return *this;
       }
       index = other.index;
+      spanHint = other.spanHint;
       static_assert(std::is_trivially_destructible_v<decltype(container)>);
       new(&container) decltype(container)(other.container.staticArguments,
-                                          other.container.arguments, other.container.spanArguments);
+                                          other.container.arguments, other.container.spanArguments,
+                                          other.container.spanOffsets);
       return *this;
     }
     Iterator& operator=(Iterator const& other) {
@@ -804,9 +3193,11 @@ public:
         return *this;
       }
       index = other.index;
+      spanHint = other.spanHint;
       static_assert(std::is_trivially_destructible_v<decltype(container)>);
       new(&container) decltype(container)(other.container.staticArguments,
-                                          other.container.arguments, other.container.spanArguments);
+                                          other.container.arguments, other.container.spanArguments,
+                                          other.container.spanOffsets);
       return *this;
     }
     Iterator(Iterator const& other) = default;
@@ -842,96 +3233,17 @@ public:
   ArgumentWrapper<IsConstWrapper, AdditionalAtoms...> front() const { return at(0); }
 
   ArgumentWrapper<IsConstWrapper, AdditionalAtoms...> operator[](size_t index) const {
-    if constexpr((std::tuple_size_v<StaticArgumentsContainer>) > 0) {
-      if(index < std::tuple_size_v<StaticArgumentsContainer>) {
-        return getStaticArgument(index);
-      }
-    } else if((index - std::tuple_size_v<StaticArgumentsContainer>) < arguments.size()) {
-      return arguments[index - std::tuple_size_v<StaticArgumentsContainer>];
-    } else {
-      auto argumentPrefixScan = std::tuple_size_v<StaticArgumentsContainer> + arguments.size();
-      for(auto& spanArgument : spanArguments) {
-        if(index >= argumentPrefixScan &&
-           index < argumentPrefixScan +
-                       std::visit([](auto&& spanArgument) { return spanArgument.size(); },
-                                  spanArgument)) {
-          return std::visit(
-              [&](auto&& spanArgument) -> ArgumentWrapper<IsConstWrapper, AdditionalAtoms...> {
-                if constexpr((std::is_same_v<std::decay_t<decltype(spanArgument.at(0))>,
-                                             std::vector<bool>::const_reference> &&
-                              !IsConstWrapper) ||
-                             ((std::is_const_v<std::remove_reference_t<decltype(spanArgument)>> ||
-                               std::is_const_v<std::remove_reference_t<decltype(spanArgument.at(
-                                   0))>>)&&!IsConstWrapper)) {
-                  throw std::runtime_error("cannot convert const span to non-const argument");
-                } else {
-                  return spanArgument[index - argumentPrefixScan];
-                }
-              },
-              spanArgument);
-        }
-        argumentPrefixScan +=
-            std::visit([](auto&& spanArgument) { return spanArgument.size(); }, spanArgument);
-      }
-    }
-#if defined(_MSC_VER)
-    __assume(0);
-#else
-    __builtin_unreachable();
-#endif
+    return at(index);
   }
 
   ArgumentWrapper<IsConstWrapper, AdditionalAtoms...> getSpanArgument(size_t index) const {
-    auto argumentPrefixScan = std::tuple_size_v<StaticArgumentsContainer> + arguments.size();
-
-    for(auto& spanArgument : spanArguments) {
-      if(index >= argumentPrefixScan &&
-         index < argumentPrefixScan +
-                     std::visit([](auto& span) { return span.size(); }, spanArgument)) {
-        return std::visit(
-            [&](auto&& spanArgument) -> ArgumentWrapper<IsConstWrapper, AdditionalAtoms...> {
-              if constexpr((!IsConstWrapper &&
-                            std::is_same_v<std::decay_t<decltype(spanArgument.at(0))>,
-                                           std::vector<bool>::const_reference>) ||
-                           ((std::is_const_v<std::remove_reference_t<decltype(spanArgument)>> ||
-                             std::is_const_v<std::remove_reference_t<decltype(spanArgument.at(
-                                 0))>>)&&!IsConstWrapper)) {
-                throw std::runtime_error("cannot convert const span to non-const argument");
-              } else if constexpr(
-
-                  std::is_same_v<std::decay_t<decltype(spanArgument.at(0))>,
-                                 std::vector<bool>::reference> ||
-                  std::is_same_v<std::decay_t<decltype(spanArgument.at(0))>,
-                                 std::vector<bool>::const_reference>) {
-                if constexpr(IsConstWrapper ||
-                             std::is_same_v<std::decay_t<decltype(spanArgument.at(0))>,
-                                            std::vector<bool>::const_reference>) {
-                  return std::vector<bool>::const_reference(
-                      spanArgument.at(index - argumentPrefixScan));
-                } else {
-                  return std::vector<bool>::reference(spanArgument.at(index - argumentPrefixScan));
-                }
-              } else {
-                return spanArgument.at(index - argumentPrefixScan);
-              }
-            },
-            spanArgument);
-      }
-      argumentPrefixScan +=
-          std::visit([](auto&& spanArgument) { return spanArgument.size(); }, spanArgument);
-    }
-    throw std::out_of_range("Expression has no argument with index " + std::to_string(index));
+    auto spanHint = size_t(0);
+    return getSpanArgument(index, spanHint);
   }
+
   ArgumentWrapper<IsConstWrapper, AdditionalAtoms...> at(size_t index) const {
-    if constexpr((std::tuple_size_v<StaticArgumentsContainer>) > 0) {
-      if(index < std::tuple_size_v<StaticArgumentsContainer>) {
-        return getStaticArgument(index);
-      }
-    }
-    if((index - std::tuple_size_v<StaticArgumentsContainer>) < arguments.size()) {
-      return arguments.at(index - std::tuple_size_v<StaticArgumentsContainer>);
-    }
-    return getSpanArgument(index);
+    auto spanHint = size_t(0);
+    return at(index, spanHint);
   }
 
   operator // NOLINT(hicpp-explicit-conversions)
@@ -995,6 +3307,162 @@ private:
   StaticArgumentsTuple staticArguments{};
   ExpressionArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...> arguments{};
   ExpressionSpanArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...> spanArguments{};
+  /**
+   * the span arguments cannot be modified in place (only moved out), so the offsets are computed
+   * once on construction and only need to be reset when the span arguments are moved out
+   */
+  ExpressionSpanOffsets spanOffsets{};
+  /**
+   * the structural hash (see hash()) -- reset whenever the arguments are exposed for modification
+   * (and not cached while a mutable argument wrapper is alive)
+   */
+  CachedHash cachedHash{};
+
+  /**
+   * the arguments of a shared expression (see share()) -- they are immutable and reference
+   * counted, so clones of a shared expression are constant time. The local arguments, spanArguments
+   * and spanOffsets are empty while an expression is shared
+   */
+  struct SharedArguments {
+    ExpressionArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...> arguments;
+    ExpressionSpanArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...> spanArguments;
+    ExpressionSpanOffsets spanOffsets;
+  };
+  std::shared_ptr<SharedArguments> sharedArguments{};
+
+  ComplexExpressionWithAdditionalCustomAtoms(Symbol const& head,
+                                             std::shared_ptr<SharedArguments> sharedArguments)
+      : head(head), sharedArguments(std::move(sharedArguments)) {}
+
+  ExpressionArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...> const&
+  storedArguments() const {
+    return sharedArguments ? sharedArguments->arguments : arguments;
+  }
+  ExpressionSpanArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...> const&
+  storedSpanArguments() const {
+    return sharedArguments ? sharedArguments->spanArguments : spanArguments;
+  }
+  ExpressionSpanOffsets const& storedSpanOffsets() const {
+    return sharedArguments ? sharedArguments->spanOffsets : spanOffsets;
+  }
+
+  /**
+   * Takes the arguments back out of the shared block before they are modified or moved out. If
+   * other expressions still share the block, the arguments are cloned (which is cheap for shared
+   * subexpressions and spans)
+   */
+  void unshare() {
+    if(!sharedArguments) {
+      return;
+    }
+    auto shared = std::move(sharedArguments);
+    if(shared.use_count() == 1) {
+      arguments = std::move(shared->arguments);
+      spanArguments = std::move(shared->spanArguments);
+      spanOffsets = std::move(shared->spanOffsets);
+      return;
+    }
+    arguments.reserve(shared->arguments.size());
+    for(auto const& argument : shared->arguments) {
+      arguments.emplace_back(argument.clone(CloneReason::COPY_ON_WRITE));
+    }
+    spanArguments.reserve(shared->spanArguments.size());
+    for(auto const& spanArgument : shared->spanArguments) {
+      spanArguments.push_back(std::visit(
+          [](auto const& span)
+              -> ExpressionSpanArgumentWithAdditionalCustomAtoms<AdditionalCustomAtoms...> {
+            return span.clone(CloneReason::COPY_ON_WRITE);
+          },
+          spanArgument));
+    }
+    spanOffsets = shared->spanOffsets;
+  }
+
+  template <typename, typename...> friend class ComplexExpressionWithAdditionalCustomAtoms;
+
+  /**
+   * the bulk comparison of span ranges in operator==: integers (and dates and decimals) are
+   * compared bytewise, floating point numbers in blocks without early exit within a block (so
+   * that the loop vectorizes -- memcmp would get -0.0 and NaN wrong)
+   */
+  static constexpr size_t elementsEqualBlockSize = 256;
+  template <typename LeftIterator, typename RightIterator>
+  static bool elementsEqual(LeftIterator left, RightIterator right, size_t n) {
+    using T = std::remove_const_t<std::remove_pointer_t<LeftIterator>>;
+    if constexpr(std::is_pointer_v<LeftIterator> && std::has_unique_object_representations_v<T>) {
+      return n == 0 || std::memcmp(left, right, n * sizeof(T)) == 0;
+    } else if constexpr(std::is_pointer_v<LeftIterator> && std::is_floating_point_v<T>) {
+      for(auto blockBegin = size_t(0); blockBegin < n; blockBegin += elementsEqualBlockSize) {
+        auto const blockEnd = std::min(n, blockBegin + elementsEqualBlockSize);
+        auto equal = true;
+        for(auto i = blockBegin; i < blockEnd; i++) {
+          equal &= left[i] == right[i]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+        if(!equal) {
+          return false;
+        }
+      }
+      return true;
+    } else {
+      return std::equal(left, left + n, right);
+    }
+  }
+
+  /**
+   * whether any span argument has missing elements (see ValidityBitmap)
+   */
+  bool hasMissingSpanElements() const {
+    auto const& spans = storedSpanArguments();
+    return std::any_of(spans.begin(), spans.end(), [](auto const& span) {
+      return std::visit([](auto const& typedSpan) { return typedSpan.nullCount() > 0; }, span);
+    });
+  }
+
+  /**
+   * whether the element at a (span-relative) offset belongs to a generated span (these are only
+   * equal to the same elements of the same generated column, see operator==)
+   */
+  bool isGeneratedSpanElement(size_t offset) const {
+    auto const& offsets = storedSpanOffsets();
+    auto const span =
+        size_t(std::upper_bound(offsets.begin(), offsets.end(), offset) - offsets.begin() - 1);
+    return std::visit(
+        [](auto const& typedSpan) {
+          using T = std::remove_const_t<typename std::decay_t<decltype(typedSpan)>::element_type>;
+          return std::is_same_v<std::decay_t<decltype(typedSpan)>, Span<Generated<T>>>;
+        },
+        storedSpanArguments()[span]);
+  }
+
+  /**
+   * whether the element at a (span-relative) offset is missing
+   */
+  bool isMissingSpanElement(size_t offset) const {
+    auto const& offsets = storedSpanOffsets();
+    auto const span =
+        size_t(std::upper_bound(offsets.begin(), offsets.end(), offset) - offsets.begin() - 1);
+    return std::visit(
+        [offset = offset - offsets[span]](auto const& typedSpan) {
+          return !typedSpan.isValid(offset);
+        },
+        storedSpanArguments()[span]);
+  }
+
+  static ExpressionSpanOffsets computeSpanOffsets(
+      ExpressionSpanArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...> const&
+          spanArguments) {
+    ExpressionSpanOffsets offsets;
+    if(spanArguments.empty()) {
+      return offsets;
+    }
+    offsets.reserve(spanArguments.size() + 1);
+    offsets.push_back(0);
+    for(auto const& spanArgument : spanArguments) {
+      offsets.push_back(offsets.back() +
+                        std::visit([](auto const& span) { return span.size(); }, spanArgument));
+    }
+    return offsets;
+  }
 
 public:
   template <size_t... I>
@@ -1006,6 +3474,21 @@ public:
         arguments.at(I)))...};
   }
 
+  /**
+   * the arguments that remain once the static ones have been converted to a tuple -- if there are
+   * no static ones, the (exactly sized) buffer is taken over instead of being copied into a new one
+   */
+  static ExpressionArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...> dropStaticArguments(
+      ExpressionArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...>&& arguments) {
+    if constexpr(std::tuple_size_v<StaticArgumentsTuple> == 0) {
+      return std::move(arguments);
+    } else {
+      return {std::move_iterator(
+                  next(begin(arguments), std::tuple_size<StaticArgumentsTuple>::value)),
+              std::move_iterator(end(arguments))};
+    }
+  }
+
   template <typename T>
   void cloneIfNecessary(
       ExpressionArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...>& result,
@@ -1030,6 +3513,9 @@ public:
              ExpressionArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...>,
              ExpressionSpanArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...>>
   decompose() && {
+    unshare();
+    spanOffsets.clear();
+    cachedHash.reset();
     return {std::move(head), std::move(staticArguments), std::move(arguments),
             std::move(spanArguments)};
   }
@@ -1052,7 +3538,8 @@ public:
       ExpressionSpanArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...>&& spanArguments =
           {})
       : head(head), staticArguments(std::move(staticArguments)), arguments(std::move(arguments)),
-        spanArguments(std::move(spanArguments)) {}
+        spanArguments(std::move(spanArguments)),
+        spanOffsets(computeSpanOffsets(this->spanArguments)) {}
 
   ComplexExpressionWithAdditionalCustomAtoms(
       Symbol&& head, StaticArgumentsTuple&& staticArguments,
@@ -1060,7 +3547,8 @@ public:
       ExpressionSpanArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...>&& spanArguments =
           {})
       : head(std::move(head)), staticArguments(std::move(staticArguments)),
-        arguments(std::move(arguments)), spanArguments(std::move(spanArguments)) {}
+        arguments(std::move(arguments)), spanArguments(std::move(spanArguments)),
+        spanOffsets(computeSpanOffsets(this->spanArguments)) {}
 
   template <typename = std::enable_if<std::tuple_size<StaticArgumentsTuple>::value == 0>>
   explicit ComplexExpressionWithAdditionalCustomAtoms(
@@ -1071,9 +3559,7 @@ public:
             convertToTuple(
                 arguments,
                 std::make_index_sequence<std::tuple_size<StaticArgumentsTuple>::value>()),
-            {std::move_iterator(
-                 next(begin(arguments), std::tuple_size<StaticArgumentsTuple>::value)),
-             std::move_iterator(end(arguments))}){};
+            dropStaticArguments(std::move(arguments))){};
 
   template <typename = std::enable_if<std::tuple_size<StaticArgumentsTuple>::value == 0>>
   explicit ComplexExpressionWithAdditionalCustomAtoms(
@@ -1084,9 +3570,7 @@ public:
             convertToTuple(
                 arguments,
                 std::make_index_sequence<std::tuple_size<StaticArgumentsTuple>::value>()),
-            {std::move_iterator(
-                 next(begin(arguments), std::tuple_size<StaticArgumentsTuple>::value)),
-             std::move_iterator(end(arguments))}){};
+            dropStaticArguments(std::move(arguments))){};
 
   operator ComplexExpressionWithAdditionalCustomAtoms< // NOLINT(hicpp-explicit-conversions)
       std::tuple<>, AdditionalCustomAtoms...>() const {
@@ -1128,34 +3612,47 @@ public:
           },
           std::move(span));
     }
+    spanOffsets = computeSpanOffsets(spanArguments);
   }
 
   ExpressionArgumentsWithAdditionalCustomAtomsWrapper<decltype(staticArguments), false,
                                                       AdditionalCustomAtoms...>
   getArguments() {
-    return {staticArguments, arguments, spanArguments};
+    unshare();
+    return {staticArguments, arguments, spanArguments, spanOffsets, &cachedHash};
   }
   ExpressionArgumentsWithAdditionalCustomAtomsWrapper<decltype(staticArguments) const, true,
                                                       AdditionalCustomAtoms...>
   getArguments() const {
-    return {staticArguments, arguments, spanArguments};
+    return {staticArguments, storedArguments(), storedSpanArguments(), storedSpanOffsets()};
   }
 
   ExpressionArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...> const&
   getDynamicArguments() const& {
-    return arguments;
+    return storedArguments();
   };
 
   ExpressionArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...> getDynamicArguments() && {
+    unshare();
+    cachedHash.reset();
     return std::move(arguments);
   };
 
   auto const& getStaticArguments() const& { return staticArguments; }
-  auto getStaticArguments() && { return std::move(staticArguments); }
-  auto const& getSpanArguments() const& { return spanArguments; }
-  auto getSpanArguments() && { return std::move(spanArguments); }
+  auto getStaticArguments() && {
+    cachedHash.reset();
+    return std::move(staticArguments);
+  }
+  auto const& getSpanArguments() const& { return storedSpanArguments(); }
+  auto getSpanArguments() && {
+    unshare();
+    spanOffsets.clear();
+    cachedHash.reset();
+    return std::move(spanArguments);
+  }
 
   ExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...> getArgument(size_t index) && {
+    cachedHash.reset();
     return visit(
         [](auto&& unwrapped) -> ExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...> {
           if constexpr(boss::utilities::isInstanceOfTemplate<::std::decay_t<decltype(unwrapped)>,
@@ -1181,6 +3678,9 @@ public:
                   return ::std::forward<decltype(arg)>(arg);
                 },
                 ::std::forward<decltype(unwrapped)>(unwrapped));
+          } else if constexpr(::std::is_same_v<::std::decay_t<decltype(unwrapped)>,
+                                               ::std::string_view>) {
+            return ::std::string(unwrapped);
           } else {
             return ::std::forward<decltype(unwrapped)>(unwrapped);
           }
@@ -1226,6 +3726,9 @@ public:
                   return arg.clone(reason...);
                 },
                 unwrapped);
+          } else if constexpr(::std::is_same_v<::std::decay_t<decltype(unwrapped)>,
+                                               ::std::string_view>) {
+            return ::std::string(unwrapped);
           } else {
             return unwrapped;
           }
@@ -1233,6 +3736,99 @@ public:
         getArguments().at(index).getArgument());
   }
 
+  /**
+   * Calls visitor(T const* data, size_t n) once per contiguous segment of arguments of type T, in
+   * argument order. Span arguments are passed without copying. Runs of consecutive dynamic
+   * arguments of the same arithmetic type (bool and the numeric types) are gathered into a
+   * temporary buffer. Any other argument (strings, symbols, complex expressions, ...) is passed in
+   * place as a segment of one. Spans whose elements are not a contiguous array are passed in
+   * blocks of at most visitChunksBlockSize elements: bool spans (backed by std::vector<bool>) are
+   * copied out, string spans (Span<std::string_view>) and dictionary-encoded spans
+   * (Span<DictionaryEncoded>) are passed as blocks of (decoded) std::string_views, encoded integer
+   * spans (Span<Encoded<T>>) are decoded, selection views (Span<Selected<T>>) are gathered, and
+   * generated spans (Span<Generated<T>>) are produced into a single buffer (so a column that is not
+   * resident is streamed).
+   *
+   * Chunks of spans include their missing elements (with unspecified values). Visitors that are
+   * callable as visitor(T const* data, size_t n, ValidityBitmap const& validity) are passed the
+   * validity of the chunk's elements, too (absent, i.e., all valid, for chunks that are not
+   * from spans); other visitors have to skip missing elements some other way.
+   */
+  static constexpr size_t visitChunksBlockSize = 4096;
+  template <typename Visitor> void visitChunks(Visitor&& visitor) const {
+    auto const visit = [&visitor](auto const* data, size_t n, ValidityBitmap const& validity) {
+      if constexpr(std::is_invocable_v<Visitor&, decltype(data), size_t, ValidityBitmap const&>) {
+        visitor(data, n, validity);
+      } else {
+        visitor(data, n);
+      }
+    };
+    std::apply(
+        [&visit](auto const&... staticArgument) { (visit(&staticArgument, 1, {}), ...); },
+        staticArguments);
+    using ExpressionVariant =
+        typename ExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...>::SuperType;
+    auto const& dynamicArguments = storedArguments();
+    for(auto runBegin = dynamicArguments.begin(); runBegin != dynamicArguments.end();) {
+      auto runEnd =
+          std::find_if(runBegin, dynamicArguments.end(), [&runBegin](auto const& argument) {
+            return argument.index() != runBegin->index();
+          });
+      std::visit(
+          [&visit, &runBegin, &runEnd](auto const& first) {
+            using T = std::decay_t<decltype(first)>;
+            if constexpr(std::is_arithmetic_v<T>) {
+              auto const runSize = size_t(runEnd - runBegin);
+              auto buffer = std::make_unique<T[]>(runSize); // NOLINT(*-avoid-c-arrays)
+              std::transform(runBegin, runEnd, buffer.get(),
+                             [](auto const& argument) { return std::get<T>(argument); });
+              visit(static_cast<T const*>(buffer.get()), runSize, {});
+            } else {
+              std::for_each(runBegin, runEnd, [&visit](auto const& argument) {
+                visit(&std::get<T>(argument), size_t(1), {});
+              });
+            }
+          },
+          (ExpressionVariant const&)*runBegin);
+      runBegin = runEnd;
+    }
+    for(auto const& spanArgument : storedSpanArguments()) {
+      std::visit(
+          [&visit](auto const& span) {
+            using T = std::remove_const_t<typename std::decay_t<decltype(span)>::element_type>;
+            using SpanType = std::decay_t<decltype(span)>;
+            if constexpr(std::is_same_v<SpanType, Span<Encoded<T>>> ||
+                         std::is_same_v<SpanType, Span<Generated<T>>>) {
+              auto block = std::make_unique<T[]>( // NOLINT(*-avoid-c-arrays)
+                  std::min(visitChunksBlockSize, span.size()));
+              for(auto blockBegin = size_t(0); blockBegin < span.size();
+                  blockBegin += visitChunksBlockSize) {
+                auto const blockSize = std::min(visitChunksBlockSize, span.size() - blockBegin);
+                if constexpr(std::is_same_v<SpanType, Span<Encoded<T>>>) {
+                  span.decode(blockBegin, blockSize, block.get());
+                } else {
+                  span.produce(blockBegin, blockSize, block.get());
+                }
+                visit(static_cast<T const*>(block.get()), blockSize,
+                      span.getValidity().slice(blockBegin, blockSize));
+              }
+            } else if constexpr(!std::is_pointer_v<decltype(span.begin())>) {
+              for(auto blockBegin = size_t(0); blockBegin < span.size();
+                  blockBegin += visitChunksBlockSize) {
+                auto const blockSize = std::min(visitChunksBlockSize, span.size() - blockBegin);
+                auto block = std::make_unique<T[]>(blockSize); // NOLINT(*-avoid-c-arrays)
+                std::copy_n(span.begin() + blockBegin, blockSize, block.get());
+                visit(static_cast<T const*>(block.get()), blockSize,
+                      span.getValidity().slice(blockBegin, blockSize));
+              }
+            } else if(span.size() > 0) {
+              visit(static_cast<T const*>(span.begin()), span.size(), span.getValidity());
+            }
+          },
+          spanArgument);
+    }
+  }
+
   Symbol const& getHead() const& { return head; };
   Symbol getHead() && { return std::move(head); };
 
@@ -1249,10 +3845,118 @@ public:
     if(getHead() != other.getHead() || getArguments().size() != other.getArguments().size()) {
       return false;
     }
-    for(auto i = 0U; i < getArguments().size(); i++) {
-      if(getArguments()[i] != other.getArguments()[i]) {
+    // only compare hashes that have been computed already: computing them would cost a full walk
+    if(auto hash = cachedHash.peek(), otherHash = other.cachedHash.peek();
+       hash != 0 && otherHash != 0 && hash != otherHash) {
+      return false;
+    }
+    if constexpr(std::is_same_v<std::tuple<StaticArgumentTypes...>, StaticArgumentsTuple>) {
+      if(sharedArguments && sharedArguments == other.sharedArguments) {
+        return true;
+      }
+    }
+    auto const arguments = getArguments();
+    auto const otherArguments = other.getArguments();
+    auto const spansBegin = std::tuple_size_v<StaticArgumentsTuple> + storedArguments().size();
+    auto const otherSpansBegin = sizeof...(StaticArgumentTypes) + other.storedArguments().size();
+    auto const& offsets = storedSpanOffsets();
+    auto const& otherOffsets = other.storedSpanOffsets();
+    auto span = size_t(0);
+    auto otherSpan = size_t(0);
+    // missing span elements are only equal to missing span elements
+    auto const missing = hasMissingSpanElements() || other.hasMissingSpanElements();
+    for(auto i = size_t(0); i < arguments.size();) {
+      if(i < spansBegin || i < otherSpansBegin) {
+        if((i >= spansBegin && isGeneratedSpanElement(i - spansBegin)) ||
+           (i >= otherSpansBegin && other.isGeneratedSpanElement(i - otherSpansBegin)) ||
+           arguments[i] != otherArguments[i] ||
+           (missing &&
+            ((i >= spansBegin && isMissingSpanElement(i - spansBegin)) ||
+             (i >= otherSpansBegin && other.isMissingSpanElement(i - otherSpansBegin))))) {
+          return false;
+        }
+        i++;
+        continue;
+      }
+      // both sides are in their span arguments: compare the overlap of the current spans in bulk
+      auto const offset = i - spansBegin;
+      auto const otherOffset = i - otherSpansBegin;
+      while(offsets[span + 1] <= offset) {
+        span++;
+      }
+      while(otherOffsets[otherSpan + 1] <= otherOffset) {
+        otherSpan++;
+      }
+      auto const length =
+          std::min(offsets[span + 1] - offset, otherOffsets[otherSpan + 1] - otherOffset);
+      auto const equal = std::visit(
+          [&](auto const& left) {
+            using T = std::remove_const_t<typename std::decay_t<decltype(left)>::element_type>;
+            auto const& right = other.storedSpanArguments()[otherSpan];
+            auto const leftBegin = left.begin() + (offset - offsets[span]);
+            auto const rightBegin = otherOffset - otherOffsets[otherSpan];
+            auto const& rightValidity = std::visit(
+                [](auto const& typedRight) -> ValidityBitmap const& {
+                  return typedRight.getValidity();
+                },
+                right);
+            // generated elements are equal if they are the same produced elements
+            if constexpr(std::is_same_v<std::decay_t<decltype(left)>, Span<Generated<T>>>) {
+              auto const* typedRight = std::get_if<Span<Generated<T>>>(&right);
+              if(typedRight == nullptr ||
+                 !left.producesSameElement(offset - offsets[span], *typedRight, rightBegin)) {
+                return false;
+              }
+              for(auto j = size_t(0); j < length; j++) {
+                if(left.isValid(offset - offsets[span] + j) !=
+                   rightValidity.isValid(rightBegin + j)) {
+                  return false;
+                }
+              }
+              return true;
+            } else if(other.isGeneratedSpanElement(otherOffset)) {
+              return false;
+            }
+            if(left.nullCount() > 0 || rightValidity.nullCount() > 0) {
+              for(auto j = size_t(0); j < length; j++) {
+                auto const valid = left.isValid(offset - offsets[span] + j);
+                if(valid != rightValidity.isValid(rightBegin + j) ||
+                   (valid && arguments[i + j] != otherArguments[i + j])) {
+                  return false;
+                }
+              }
+              return true;
+            }
+            if constexpr(std::is_same_v<std::decay_t<decltype(left)>, Span<DictionaryEncoded>>) {
+              if(auto const* typedRight = std::get_if<Span<DictionaryEncoded>>(&right)) {
+                if(left.sharesDictionaryWith(*typedRight)) { // codes are equal iff values are
+                  return elementsEqual(left.codeData() + (offset - offsets[span]),
+                                       typedRight->codeData() + rightBegin, length);
+                }
+                return elementsEqual(leftBegin, typedRight->begin() + rightBegin, length);
+              }
+            }
+            if(auto const* typedRight = std::get_if<Span<T>>(&right)) {
+              return elementsEqual(leftBegin, typedRight->begin() + rightBegin, length);
+            }
+            if constexpr(boss::utilities::isVariantMember<
+                             Span<T const>, std::decay_t<decltype(right)>>::value) {
+              if(auto const* typedRight = std::get_if<Span<T const>>(&right)) {
+                return elementsEqual(leftBegin, typedRight->begin() + rightBegin, length);
+              }
+            }
+            for(auto j = i; j < i + length; j++) { // differently typed spans
+              if(arguments[j] != otherArguments[j]) {
+                return false;
+              }
+            }
+            return true;
+          },
+          storedSpanArguments()[span]);
+      if(!equal) {
         return false;
       }
+      i += length;
     }
     return true;
   }
@@ -1260,12 +3964,65 @@ public:
     return !(*this == other);
   }
 
+  /**
+   * A structural hash that is consistent with operator==: static, dynamic and span arguments with
+   * the same values hash the same (as do missing span elements, whatever their values). Generated
+   * elements are hashed by their producer and position, not produced. It is cached, so hashing a
+   * parent reuses the hashes of its (unmodified) children.
+   */
+  std::size_t hash() const {
+    return cachedHash.get([this] {
+      using boss::utilities::hashCombine;
+      auto result = head.hash();
+      std::apply(
+          [&result](auto const&... staticArgument) {
+            ((result = hashCombine(result, [](auto const& argument) -> std::size_t {
+                if constexpr(isComplexExpression<decltype(argument)>) {
+                  return argument.hash();
+                } else {
+                  return hashAtom(argument);
+                }
+              }(staticArgument))),
+             ...);
+          },
+          staticArguments);
+      for(auto const& argument : storedArguments()) {
+        result = hashCombine(result, argument.hash());
+      }
+      static auto const missingHash = std::hash<std::string_view>{}("Missing");
+      for(auto const& spanArgument : storedSpanArguments()) {
+        std::visit(
+            [&result](auto const& span) {
+              using T = std::remove_const_t<typename std::decay_t<decltype(span)>::element_type>;
+              if constexpr(std::is_same_v<std::decay_t<decltype(span)>, Span<Generated<T>>>) {
+                for(auto index = size_t(0); index < span.size(); ++index) {
+                  result = hashCombine(result, span.isValid(index) ? span.elementHash(index)
+                                                                   : missingHash);
+                }
+              } else {
+                auto index = size_t(0);
+                for(auto it = span.begin(); it != span.end(); ++it, ++index) {
+                  result = hashCombine(result, span.isValid(index) ? hashAtom(static_cast<T>(*it))
+                                                                   : missingHash);
+                }
+              }
+            },
+            spanArgument);
+      }
+      return result;
+    });
+  }
+
   template <typename... Reason>
   ComplexExpressionWithAdditionalCustomAtoms clone(Reason... reason) const {
     checkCloneWithoutReason(reason...);
+    if(sharedArguments) {
+      return ComplexExpressionWithAdditionalCustomAtoms(head, sharedArguments);
+    }
     ExpressionArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...> copiedArgs;
     ExpressionSpanArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...> newSpanArguments;
     static_assert(std::tuple_size_v<decltype(staticArguments)> == 0);
+    copiedArgs.reserve(arguments.size());
     for(auto const& arg : getDynamicArguments()) {
       copiedArgs.emplace_back(arg.clone(reason...));
     }
@@ -1284,6 +4041,59 @@ public:
                                                       std::move(newSpanArguments));
   }
 
+  /**
+   * Re-creates the argument containers (recursively) from the current expression memory resource.
+   * Unlike clone, this moves atoms and spans rather than copying them: it is what takes an
+   * expression out of an arena before the arena is released.
+   */
+  ComplexExpressionWithAdditionalCustomAtoms relocate() && {
+    static_assert(std::tuple_size_v<decltype(staticArguments)> == 0);
+    unshare();
+    ExpressionArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...> relocatedArgs;
+    relocatedArgs.reserve(arguments.size());
+    for(auto&& arg : arguments) {
+      relocatedArgs.emplace_back(std::move(arg).relocate());
+    }
+    ExpressionSpanArgumentsWithAdditionalCustomAtoms<AdditionalCustomAtoms...> relocatedSpans;
+    relocatedSpans.reserve(spanArguments.size());
+    std::move(spanArguments.begin(), spanArguments.end(), std::back_inserter(relocatedSpans));
+    return ComplexExpressionWithAdditionalCustomAtoms(std::move(head), {}, std::move(relocatedArgs),
+                                                      std::move(relocatedSpans));
+  }
+
+  /**
+   * Turns the expression (and, recursively, all its subexpressions and spans) into a shared
+   * expression: its arguments move into an immutable, reference-counted block that is shared by
+   * all its clones, which makes cloning constant time. Shared expressions are copy-on-write:
+   * mutable access to the arguments (or moving them out) takes a private copy if the block is
+   * still shared with other expressions (see unshare())
+   */
+  ComplexExpressionWithAdditionalCustomAtoms share() && {
+    static_assert(std::tuple_size_v<decltype(staticArguments)> == 0);
+    if(sharedArguments) {
+      return std::move(*this);
+    }
+    for(auto& argument : arguments) {
+      argument = std::move(argument).share();
+    }
+    for(auto& spanArgument : spanArguments) {
+      spanArgument = std::visit(
+          [](auto&& span)
+              -> ExpressionSpanArgumentWithAdditionalCustomAtoms<AdditionalCustomAtoms...> {
+            return std::forward<decltype(span)>(span).share();
+          },
+          std::move(spanArgument));
+    }
+    sharedArguments = std::make_shared<SharedArguments>(
+        SharedArguments{std::move(arguments), std::move(spanArguments), std::move(spanOffsets)});
+    arguments.clear();
+    spanArguments.clear();
+    spanOffsets.clear();
+    return std::move(*this);
+  }
+
+  bool isShared() const { return bool(sharedArguments); }
+
   /**
    * a specialization for complex expressions is needed. Otherwise the complex
    * expression and all its arguments have to be copied to be converted to an
@@ -1353,6 +4163,29 @@ T get(generic::ExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...>&& e
   }
 }
 
+/**
+ * whether T is one of the types an Expression can hold (as opposed to, e.g., the string views that
+ * only argument wrappers hold)
+ */
+template <typename T, typename Expression, typename = void>
+struct IsExpressionAlternative : std::false_type {};
+template <typename T, typename Expression>
+struct IsExpressionAlternative<T, Expression,
+                               std::void_t<typename std::decay_t<Expression>::SuperType>>
+    : boss::utilities::isVariantMember<T, typename std::decay_t<Expression>::SuperType> {};
+template <typename T, typename Expression>
+inline constexpr bool isExpressionAlternative = IsExpressionAlternative<T, Expression>::value;
+
+/**
+ * decoded (or produced) span elements are wrapped by value (see isWrappedByValue), so a mutable
+ * reference to one would be a reference to the wrapper's copy: writes through it would be lost
+ * (and it would dangle with the wrapper). They can be read through a const wrapper
+ */
+[[noreturn]] inline void throwModifiedDecodedElement() {
+  throw ::std::logic_error("decoded span elements cannot be modified, read them through a const "
+                           "argument wrapper (or copy them out)");
+}
+
 template <typename T, auto ConstWrappee, typename... AdditionalCustomAtoms>
 T& get(generic::ArgumentWrapper<ConstWrappee, AdditionalCustomAtoms...> const& wrapper) {
   try {
@@ -1368,12 +4201,24 @@ T& get(generic::ArgumentWrapper<ConstWrappee, AdditionalCustomAtoms...> const& w
               return argument;
             }
             throw ::std::bad_variant_access();
+          } else if constexpr(isWrappedByValue<decltype(argument)>) {
+            if constexpr(::std::is_same_v<::std::decay_t<T>, ::std::decay_t<decltype(argument)>>) {
+              if constexpr(!ConstWrappee &&
+                           !::std::is_same_v<::std::decay_t<T>, ::std::string_view>) {
+                throwModifiedDecodedElement();
+              }
+              // the value is held by the wrapper (for views, it is the view that is mutable, not
+              // the characters)
+              return const_cast<T&>(argument); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+            }
+            throw ::std::bad_variant_access();
           } else if constexpr(boss::utilities::isInstanceOfTemplate<
                                   ::std::decay_t<decltype(argument)>,
                                   MovableReferenceWrapper>::value) {
             if constexpr(boss::utilities::isInstanceOfTemplate<
                              ::std::decay_t<decltype(argument.get())>,
-                             ExpressionWithAdditionalCustomAtoms>::value) {
+                             ExpressionWithAdditionalCustomAtoms>::value &&
+                         isExpressionAlternative<T, decltype(argument.get())>) {
               return ::std::get<T>(argument.get());
             }
             throw ::std::bad_variant_access();
@@ -1394,11 +4239,14 @@ T const& get(ArgumentWrapper<true, AdditionalCustomAtoms...> const& wrapper) {
         [](auto const& wrappee) -> T const& {
           if constexpr(boss::utilities::isInstanceOfTemplate<::std::decay_t<decltype(wrappee)>,
                                                              MovableReferenceWrapper>::value) {
-            if constexpr(::std::is_same_v<typename ::std::decay_t<decltype(wrappee)>::type, T>) {
+            // span elements are wrapped as const references (e.g., of selection views)
+            using Referee = typename ::std::decay_t<decltype(wrappee)>::type;
+            if constexpr(::std::is_same_v<::std::remove_const_t<Referee>, T>) {
               return wrappee.get();
             } else if constexpr(boss::utilities::isInstanceOfTemplate<
                                     ::std::decay_t<decltype(wrappee.get())>,
-                                    ExpressionWithAdditionalCustomAtoms>::value) {
+                                    ExpressionWithAdditionalCustomAtoms>::value &&
+                                isExpressionAlternative<T, decltype(wrappee.get())>) {
               return std::get<T>(wrappee.get());
             }
             throw ::std::bad_variant_access();
@@ -1410,6 +4258,11 @@ T const& get(ArgumentWrapper<true, AdditionalCustomAtoms...> const& wrapper) {
               return wrappee;
             }
             throw ::std::bad_variant_access();
+          } else if constexpr(isWrappedByValue<decltype(wrappee)>) {
+            if constexpr(::std::is_same_v<::std::decay_t<decltype(wrappee)>, T>) {
+              return wrappee;
+            }
+            throw ::std::bad_variant_access();
           } else {
             return get<T>(wrappee);
           }
@@ -1432,7 +4285,9 @@ bool holds_alternative(
   return ::std::visit(
       [](auto& argument) {
         if constexpr(::std::is_same_v<::std::decay_t<decltype(argument)>,
-                                      MovableReferenceWrapper<T>>) {
+                                      MovableReferenceWrapper<T>> ||
+                     ::std::is_same_v<::std::decay_t<decltype(argument)>,
+                                      MovableReferenceWrapper<T const>>) {
           return true;
         } else if constexpr(::std::is_same_v<::std::decay_t<decltype(argument)>,
                                              ::std::vector<bool>::reference>) {
@@ -1440,12 +4295,15 @@ bool holds_alternative(
 
             return true;
           }
+        } else if constexpr(isWrappedByValue<decltype(argument)>) {
+          return ::std::is_same_v<::std::decay_t<T>, ::std::decay_t<decltype(argument)>>;
         } else if constexpr(boss::utilities::isInstanceOfTemplate<
                                 ::std::decay_t<decltype(argument)>,
                                 MovableReferenceWrapper>::value) {
           if constexpr(boss::utilities::isInstanceOfTemplate<
                            ::std::decay_t<decltype(argument.get())>,
-                           ExpressionWithAdditionalCustomAtoms>::value) {
+                           ExpressionWithAdditionalCustomAtoms>::value &&
+                       isExpressionAlternative<T, decltype(argument.get())>) {
             return ::std::holds_alternative<T>(argument.get());
           }
         }
@@ -1459,7 +4317,9 @@ decltype(auto) get_if(ArgumentWrapper<ConstWrappee, AdditionalCustomAtoms...> co
   return ::std::visit(
       [](auto& argument) -> std::conditional_t<ConstWrappee, T const*, T*> {
         if constexpr(::std::is_same_v<::std::decay_t<decltype(argument)>,
-                                      MovableReferenceWrapper<T>>) {
+                                      MovableReferenceWrapper<T>> ||
+                     (ConstWrappee && ::std::is_same_v<::std::decay_t<decltype(argument)>,
+                                                       MovableReferenceWrapper<T const>>)) {
           return &argument.get();
         } else if constexpr(::std::is_same_v<::std::decay_t<decltype(argument)>,
                                              ::std::vector<bool>::reference>) {
@@ -1468,12 +4328,22 @@ decltype(auto) get_if(ArgumentWrapper<ConstWrappee, AdditionalCustomAtoms...> co
             return &argument;
           }
           return nullptr;
+        } else if constexpr(isWrappedByValue<decltype(argument)>) {
+          if constexpr(::std::is_same_v<::std::decay_t<T>, ::std::decay_t<decltype(argument)>>) {
+            if constexpr(!ConstWrappee &&
+                         !::std::is_same_v<::std::decay_t<T>, ::std::string_view>) {
+              throwModifiedDecodedElement();
+            }
+            return const_cast<T*>(&argument); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+          }
+          return nullptr;
         } else if constexpr(boss::utilities::isInstanceOfTemplate<
                                 ::std::decay_t<decltype(argument)>,
                                 MovableReferenceWrapper>::value) {
           if constexpr(boss::utilities::isInstanceOfTemplate<
                            ::std::decay_t<decltype(argument.get())>,
-                           ExpressionWithAdditionalCustomAtoms>::value) {
+                           ExpressionWithAdditionalCustomAtoms>::value &&
+                       isExpressionAlternative<T, decltype(argument.get())>) {
             return ::std::get_if<T>(&argument.get());
           }
           return nullptr;
@@ -1501,7 +4371,15 @@ using ExpressionSpanArgument = DefaultExpressionSystem::ExpressionSpanArgument;
 
 using expressions::ComplexExpression;
 using expressions::ComplexExpressionWithStaticArguments;
+using expressions::Date;
+using expressions::Decimal;
 using expressions::DefaultExpressionSystem;
+using expressions::DictionaryEncoded;
+using expressions::Encoded;
+using expressions::Encoding;
+using expressions::Generated;
+using expressions::PackedBool;
+using expressions::Selected;
 using expressions::Expression;
 using expressions::ExpressionArguments;
 using expressions::Span; // NOLINT
@@ -1559,7 +4437,33 @@ decltype(auto) visit(Func&& func,
 };
 template <> struct hash<boss::expressions::Symbol> {
   ::std::size_t operator()(boss::expressions::Symbol const& s) const noexcept {
-    return ::std::hash<::std::string>{}(s.getName());
+    return s.hash();
+  }
+};
+template <> struct hash<boss::expressions::Date> {
+  ::std::size_t operator()(boss::expressions::Date const& d) const noexcept {
+    return hash<::std::int32_t>{}(d.getDaysSinceEpoch());
+  }
+};
+template <> struct hash<boss::expressions::Decimal> {
+  ::std::size_t operator()(boss::expressions::Decimal const& d) const noexcept {
+    return hash<::std::int64_t>{}(d.getUnscaledValue());
+  }
+};
+template <typename... AdditionalCustomAtoms>
+struct hash<
+    boss::expressions::generic::ExpressionWithAdditionalCustomAtoms<AdditionalCustomAtoms...>> {
+  ::std::size_t operator()(boss::expressions::generic::ExpressionWithAdditionalCustomAtoms<
+                           AdditionalCustomAtoms...> const& e) const {
+    return e.hash();
+  }
+};
+template <typename StaticArgumentsTuple, typename... AdditionalCustomAtoms>
+struct hash<boss::expressions::generic::ComplexExpressionWithAdditionalCustomAtoms<
+    StaticArgumentsTuple, AdditionalCustomAtoms...>> {
+  ::std::size_t operator()(boss::expressions::generic::ComplexExpressionWithAdditionalCustomAtoms<
+                           StaticArgumentsTuple, AdditionalCustomAtoms...> const& e) const {
+    return e.hash();
   }
 };
 
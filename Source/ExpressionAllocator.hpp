@@ -0,0 +1,85 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+namespace boss {
+namespace expressions {
+
+/**
+ * The memory resource that the argument containers of expressions allocate from on this thread.
+ * This is the heap unless an arena (or any other std::pmr resource) has been made current using a
+ * ScopedExpressionMemoryResource.
+ */
+inline std::pmr::memory_resource*& currentExpressionMemoryResource() {
+  thread_local std::pmr::memory_resource* resource = std::pmr::new_delete_resource();
+  return resource;
+}
+
+/**
+ * Makes a memory resource current for the lifetime of the object (and restores the previous one
+ * afterwards). Everything allocated from the resource must be destroyed (or relocated, see
+ * ComplexExpression::relocate) before the resource itself is released.
+ */
+class ScopedExpressionMemoryResource {
+  std::pmr::memory_resource* previous;
+
+public:
+  explicit ScopedExpressionMemoryResource(std::pmr::memory_resource* resource)
+      : previous(std::exchange(currentExpressionMemoryResource(), resource)) {}
+  ~ScopedExpressionMemoryResource() { currentExpressionMemoryResource() = previous; }
+  ScopedExpressionMemoryResource(ScopedExpressionMemoryResource const&) = delete;
+  ScopedExpressionMemoryResource(ScopedExpressionMemoryResource&&) = delete;
+  ScopedExpressionMemoryResource& operator=(ScopedExpressionMemoryResource const&) = delete;
+  ScopedExpressionMemoryResource& operator=(ScopedExpressionMemoryResource&&) = delete;
+};
+
+/**
+ * A stateless allocator that allocates from the current expression memory resource. Every
+ * allocation is prefixed with a pointer to the resource it came from, so all instances compare
+ * equal: containers can be moved, swapped and destroyed no matter which resource is current at that
+ * point (in particular, they do not change type when an arena is used).
+ */
+template <typename T> class ExpressionAllocator {
+  using Resource = std::pmr::memory_resource*;
+  static constexpr size_t alignment = std::max(alignof(T), alignof(Resource));
+  static constexpr size_t headerSize = (sizeof(Resource) + alignment - 1) / alignment * alignment;
+
+public:
+  using value_type = T;
+  using is_always_equal = std::true_type;
+
+  ExpressionAllocator() noexcept = default;
+  template <typename U>
+  ExpressionAllocator(ExpressionAllocator<U> const& /*unused*/) noexcept {} // NOLINT
+
+  T* allocate(size_t n) {
+    auto* resource = currentExpressionMemoryResource();
+    auto* block =
+        static_cast<std::byte*>(resource->allocate(headerSize + n * sizeof(T), alignment));
+    std::memcpy(block + headerSize - sizeof(Resource), &resource, sizeof(Resource));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return reinterpret_cast<T*>(block + headerSize);
+  }
+
+  void deallocate(T* payload, size_t n) noexcept {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    auto* block = reinterpret_cast<std::byte*>(payload) - headerSize;
+    Resource resource = nullptr;
+    std::memcpy(&resource, block + headerSize - sizeof(Resource), sizeof(Resource));
+    resource->deallocate(block, headerSize + n * sizeof(T), alignment);
+  }
+
+  template <typename U> bool operator==(ExpressionAllocator<U> const& /*unused*/) const noexcept {
+    return true;
+  }
+  template <typename U> bool operator!=(ExpressionAllocator<U> const& /*unused*/) const noexcept {
+    return false;
+  }
+};
+
+} // namespace expressions
+} // namespace boss
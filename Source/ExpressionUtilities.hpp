@@ -1,6 +1,7 @@
 #pragma once
 #include "Expression.hpp"
 #include "Utilities.hpp"
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <map>
@@ -12,6 +13,7 @@
 #include <typeindex>
 #include <typeinfo>
 #include <utility>
+#include <vector>
 
 namespace boss::utilities {
 template <typename ExpressionSystem = DefaultExpressionSystem> class ExtensibleExpressionBuilder {
@@ -100,8 +102,45 @@ public:
   operator Symbol() const { return Symbol(s); } // NOLINT
 };
 using ExpressionBuilder = ExtensibleExpressionBuilder<>;
-static ExpressionBuilder operator""_(const char* name, size_t /*unused*/) {
-  return ExpressionBuilder(name);
+static ExpressionBuilder operator""_(const char* name, size_t length) {
+  return ExpressionBuilder(Symbol(::std::string_view(name, length)));
 };
 
+/**
+ * Replaces (recursively) all DateObject["yyyy-mm-dd"] subexpressions with Date atoms. If all the
+ * arguments of a List are dates, they are moved into a single Span<Date> (that is how date columns
+ * should be stored: as contiguous days-since-epoch integers).
+ */
+template <typename ExpressionSystem = DefaultExpressionSystem>
+typename ExpressionSystem::Expression
+convertDateObjects(typename ExpressionSystem::Expression&& expression) {
+  using ComplexExpression = typename ExpressionSystem::ComplexExpression;
+  if(!::std::holds_alternative<ComplexExpression>(expression)) {
+    return ::std::move(expression);
+  }
+  static auto const dateObjectSymbol = Symbol("DateObject");
+  static auto const listSymbol = Symbol("List");
+  auto [head, unused, arguments, spanArguments] =
+      ::std::get<ComplexExpression>(::std::move(expression)).decompose();
+  if(head == dateObjectSymbol && arguments.size() == 1 && spanArguments.empty() &&
+     ::std::holds_alternative<::std::string>(arguments[0])) {
+    return Date(::std::get<::std::string>(arguments[0]));
+  }
+  auto allDates = !arguments.empty();
+  for(auto& argument : arguments) {
+    argument = convertDateObjects<ExpressionSystem>(::std::move(argument));
+    allDates = allDates && ::std::holds_alternative<Date>(argument);
+  }
+  if(allDates && head == listSymbol && spanArguments.empty()) {
+    auto dates = ::std::vector<Date>();
+    dates.reserve(arguments.size());
+    ::std::transform(arguments.begin(), arguments.end(), ::std::back_inserter(dates),
+                     [](auto const& argument) { return ::std::get<Date>(argument); });
+    spanArguments.emplace_back(Span<Date>(::std::move(dates)));
+    arguments.clear();
+  }
+  return ComplexExpression(::std::move(head), {}, ::std::move(arguments),
+                           ::std::move(spanArguments));
+}
+
 } // namespace boss::utilities
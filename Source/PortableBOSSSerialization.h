@@ -25,6 +25,8 @@ union PortableBOSSArgumentValue {
   int64_t asLong;
   float asFloat;
   double asDouble;
+  int32_t asDate;     // days since 1970-01-01
+  int64_t asDecimal; // unscaled, i.e., in 0.0001 units
   PortableBOSSString asString;
   PortableBOSSExpressionIndex asExpression;
 };
@@ -38,6 +40,8 @@ enum PortableBOSSArgumentType : size_t {
   ARGUMENT_TYPE_DOUBLE,
   ARGUMENT_TYPE_STRING,
   ARGUMENT_TYPE_SYMBOL,
+  ARGUMENT_TYPE_DATE,
+  ARGUMENT_TYPE_DECIMAL,
   ARGUMENT_TYPE_EXPRESSION
 };
 
@@ -208,6 +212,24 @@ static size_t* makeSymbolArgument(struct PortableBOSSRootExpression* root,
   return &getExpressionArguments(root)[argumentOutputI].asString;
 };
 
+static int32_t* makeDateArgument(struct PortableBOSSRootExpression* root,
+                                 uint64_t argumentOutputI) {
+#ifdef __cplusplus
+  auto ARGUMENT_TYPE_DATE = PortableBOSSArgumentType::ARGUMENT_TYPE_DATE;
+#endif
+  getArgumentTypes(root)[argumentOutputI] = ARGUMENT_TYPE_DATE;
+  return &getExpressionArguments(root)[argumentOutputI].asDate;
+};
+
+static int64_t* makeDecimalArgument(struct PortableBOSSRootExpression* root,
+                                    uint64_t argumentOutputI) {
+#ifdef __cplusplus
+  auto ARGUMENT_TYPE_DECIMAL = PortableBOSSArgumentType::ARGUMENT_TYPE_DECIMAL;
+#endif
+  getArgumentTypes(root)[argumentOutputI] = ARGUMENT_TYPE_DECIMAL;
+  return &getExpressionArguments(root)[argumentOutputI].asDecimal;
+};
+
 static size_t* makeExpressionArgument(struct PortableBOSSRootExpression* root,
                                       uint64_t argumentOutputI) {
 #ifdef __cplusplus
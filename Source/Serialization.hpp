@@ -40,6 +40,15 @@ static_assert(
 static_assert(std::is_same_v<std::variant_alternative_t<ARGUMENT_TYPE_SYMBOL, boss::Expression>,
                              boss::Symbol>,
               "type ids wrong");
+static_assert(std::is_same_v<std::variant_alternative_t<ARGUMENT_TYPE_DATE, boss::Expression>,
+                             boss::expressions::Date>,
+              "type ids wrong");
+static_assert(std::is_same_v<std::variant_alternative_t<ARGUMENT_TYPE_DECIMAL, boss::Expression>,
+                             boss::expressions::Decimal>,
+              "type ids wrong");
+static_assert(std::is_same_v<std::variant_alternative_t<ARGUMENT_TYPE_EXPRESSION, boss::Expression>,
+                             boss::ComplexExpression>,
+              "type ids wrong");
 
 using Argument = PortableBOSSArgumentValue;
 using ArgumentType = PortableBOSSArgumentType;
@@ -201,6 +210,13 @@ struct SerializedExpression {
                         auto storedString =
                             storeString(&root, argument.getName().c_str(), reallocateFunction);
                         *makeSymbolArgument(root, argumentOutputI++) = storedString;
+                      } else if constexpr(std::is_same_v<std::decay_t<decltype(argument)>,
+                                                         boss::expressions::Date>) {
+                        *makeDateArgument(root, argumentOutputI++) = argument.getDaysSinceEpoch();
+                      } else if constexpr(std::is_same_v<std::decay_t<decltype(argument)>,
+                                                         boss::expressions::Decimal>) {
+                        *makeDecimalArgument(root, argumentOutputI++) =
+                            argument.getUnscaledValue();
                       } else {
                         throw std::runtime_error("unknown type");
                       }
@@ -248,6 +264,12 @@ public:
                    [this](std::int64_t input) { *makeLongArgument(root, 0) = input; },
                    [this](std::float_t input) { *makeFloatArgument(root, 0) = input; },
                    [this](std::double_t input) { *makeDoubleArgument(root, 0) = input; },
+                   [this](boss::expressions::Date input) {
+                     *makeDateArgument(root, 0) = input.getDaysSinceEpoch();
+                   },
+                   [this](boss::expressions::Decimal input) {
+                     *makeDecimalArgument(root, 0) = input.getUnscaledValue();
+                   },
                    [](auto&&) {
                      throw std::logic_error("uncountered unknown type during serialization");
                    }),
@@ -259,6 +281,7 @@ public:
   boss::expressions::ExpressionArguments deserializeArguments(uint64_t startChildOffset,
                                                               uint64_t endChildOffset) {
     boss::expressions::ExpressionArguments arguments;
+    arguments.reserve(endChildOffset - startChildOffset);
     for(auto childIndex = startChildOffset; childIndex < endChildOffset; childIndex++) {
       auto const& arg = flattenedArguments()[childIndex];
       auto const& type = flattenedArgumentTypes()[childIndex];
@@ -269,6 +292,9 @@ public:
           {ArgumentType::ARGUMENT_TYPE_LONG, [&] { return (arg.asLong); }},
           {ArgumentType::ARGUMENT_TYPE_FLOAT, [&] { return (arg.asFloat); }},
           {ArgumentType::ARGUMENT_TYPE_DOUBLE, [&] { return (arg.asDouble); }},
+          {ArgumentType::ARGUMENT_TYPE_DATE, [&] { return boss::expressions::Date(arg.asDate); }},
+          {ArgumentType::ARGUMENT_TYPE_DECIMAL,
+           [&] { return boss::expressions::Decimal::fromUnscaledValue(arg.asDecimal); }},
           {ArgumentType::ARGUMENT_TYPE_SYMBOL,
            [&arg, this] { return boss::Symbol(viewString(root, arg.asString)); }},
           {ArgumentType::ARGUMENT_TYPE_EXPRESSION,
@@ -312,6 +338,13 @@ public:
     template <> boss::Symbol as<boss::Symbol>(Argument const& arg) const {
       return boss::Symbol(viewString(buffer.root, arg.asString));
     };
+    template <> boss::expressions::Date as<boss::expressions::Date>(Argument const& arg) const {
+      return boss::expressions::Date(arg.asDate);
+    };
+    template <>
+    boss::expressions::Decimal as<boss::expressions::Decimal>(Argument const& arg) const {
+      return boss::expressions::Decimal::fromUnscaledValue(arg.asDecimal);
+    };
 
   public:
     LazilyDeserializedExpression(SerializedExpression const& buffer, size_t argumentIndex)
@@ -369,6 +402,10 @@ public:
       return viewString(root, flattenedArguments()[0].asString);
     case ArgumentType::ARGUMENT_TYPE_SYMBOL:
       return boss::Symbol(viewString(root, flattenedArguments()[0].asString));
+    case ArgumentType::ARGUMENT_TYPE_DATE:
+      return boss::expressions::Date(flattenedArguments()[0].asDate);
+    case ArgumentType::ARGUMENT_TYPE_DECIMAL:
+      return boss::expressions::Decimal::fromUnscaledValue(flattenedArguments()[0].asDecimal);
     case ArgumentType::ARGUMENT_TYPE_EXPRESSION:
       auto s = boss::Symbol(viewString(root, flattenedArguments()[0].asString));
       if(root->expressionCount == 0) {
@@ -1,4 +1,6 @@
 #pragma once
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -70,6 +72,20 @@ using comparability = decltype(std::declval<L>() == std::declval<R>());
 template <typename L, typename R>
 struct is_comparable<L, R, void_t<comparability<L, R>>> : std::true_type {};
 
+template <typename T, typename = void> struct is_hashable : std::false_type {};
+
+template <typename T>
+struct is_hashable<T, void_t<decltype(std::hash<T>{}(std::declval<T const&>()))>>
+    : std::true_type {};
+
+/**
+ * boost-style hash combination (order-sensitive)
+ */
+inline std::size_t hashCombine(std::size_t seed, std::size_t value) {
+  return seed ^ (value + static_cast<std::size_t>(0x9e3779b97f4a7c15ULL) + (seed << 6U) +
+                 (seed >> 2U));
+}
+
 template <typename ReturnType, typename VisitorType, typename InputType,
           typename = std::enable_if<std::is_invocable_v<VisitorType, ReturnType>>>
 ReturnType opportunisticVisitAndTransform(VisitorType&& visitor, InputType&& x) {
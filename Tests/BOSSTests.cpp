@@ -1,12 +1,17 @@
 #include <string_view>
 #define CATCH_CONFIG_RUNNER
+#include "../Source/Algorithm.hpp"
 #include "../Source/BOSS.hpp"
 #include "../Source/BootstrapEngine.hpp"
+#include "../Source/Engine.hpp"
 #include "../Source/ExpressionUtilities.hpp"
 #include "../Source/Serialization.hpp"
 #include <array>
 #include <catch2/catch.hpp>
+#include <memory_resource>
 #include <numeric>
+#include <thread>
+#include <unordered_set>
 #include <variant>
 using boss::Expression;
 using std::string;
@@ -48,6 +53,69 @@ TEST_CASE("Subspans work correctly", "[spans]") {
   CHECK(subrange2[1] == 2);
 }
 
+TEST_CASE("Shared spans are cloned without copying", "[spans][clone]") {
+  auto original = boss::Span<int64_t>(vector<int64_t>{1, 2, 3}).share();
+  CHECK(original.isShared());
+  auto clone = original.clone(CloneReason::FOR_TESTING);
+  CHECK(clone.isShared());
+  CHECK(clone.begin() == original.begin());
+  clone[1] = 4; // copy-on-write: the clone gets its own buffer
+  CHECK(clone.begin() != original.begin());
+  CHECK(original[1] == 2);
+  CHECK(clone[1] == 4);
+
+  auto iteratedClone = original.clone(CloneReason::FOR_TESTING);
+  static_assert(std::is_same_v<decltype(iteratedClone.begin()), int64_t const*>,
+                "iteration is read-only");
+  std::transform(iteratedClone.begin(), iteratedClone.end(), iteratedClone.mutableBegin(),
+                 [](auto value) { return value * 10; });
+  *iteratedClone.mutableBegin() = 7;
+  CHECK(iteratedClone.begin() != original.begin());
+  CHECK(original[0] == 1);
+  CHECK(original[2] == 3);
+  CHECK(iteratedClone[0] == 7);
+  CHECK(iteratedClone[2] == 30);
+
+  auto const buffer = std::make_shared<vector<double_t>>(vector<double_t>{1.5, 2.5});
+  auto const constSpan = boss::Span<double_t const>(buffer);
+  auto constClone = constSpan.clone(CloneReason::FOR_TESTING);
+  CHECK(constClone.begin() == buffer->data());
+  constClone.unshare();
+  CHECK(constClone.begin() != buffer->data());
+  CHECK(constClone[0] == 1.5);
+
+  auto const unshared = boss::Span<int64_t>(vector<int64_t>{1, 2, 3});
+  CHECK(!unshared.isShared());
+  CHECK(unshared.clone(CloneReason::FOR_TESTING).begin() != unshared.begin());
+
+  auto nonOwningInput = vector<bool>{true, false};
+  auto sharedBools = boss::Span<bool>(nonOwningInput).share();
+  CHECK(sharedBools.begin() != nonOwningInput.begin());
+  CHECK(sharedBools.clone(CloneReason::FOR_TESTING).begin() == sharedBools.begin());
+}
+
+TEST_CASE("Spans own their buffers through a single pointer", "[spans]") {
+  // (plus the validity bitmap, which every span carries)
+  auto const validitySize = sizeof(boss::expressions::ValidityBitmap);
+  CHECK(sizeof(boss::Span<int64_t>) <= 3 * sizeof(void*) + validitySize);
+  CHECK(sizeof(boss::Span<bool>) <=
+        sizeof(vector<bool>::iterator) * 2 + sizeof(void*) + validitySize);
+  auto destructorCalls = 0;
+  {
+    auto values = vector<int32_t>{1, 2, 3};
+    auto span = boss::Span<int32_t>(values.data(), values.size(),
+                                    [&destructorCalls]() { destructorCalls++; });
+    auto moved = std::move(span);
+    auto movedAgain = boss::Span<int32_t>();
+    movedAgain = std::move(moved);
+    auto shared = std::move(movedAgain).share();
+    auto clone = shared.clone(CloneReason::FOR_TESTING);
+    CHECK(clone.begin() == values.data());
+    CHECK(destructorCalls == 0);
+  }
+  CHECK(destructorCalls == 1);
+}
+
 TEST_CASE("Expressions", "[expressions]") {
   using SpanArguments = boss::expressions::ExpressionSpanArguments;
   using SpanArgument = boss::expressions::ExpressionSpanArgument;
@@ -151,6 +219,219 @@ TEST_CASE("Expression without arguments", "[expressions]") {
   CHECK(e.getHead().getName() == "UnevaluatedPlus");
 }
 
+TEST_CASE("Symbols are interned", "[expressions]") {
+  auto const a = boss::Symbol("Column");
+  auto const b = boss::Symbol(std::string("Col") + "umn");
+  auto const c = boss::Symbol(std::string_view("Columns").substr(0, 6));
+  CHECK(a == b);
+  CHECK(a == c);
+  CHECK(a.getID() == b.getID());
+  CHECK(a.getID() == c.getID());
+  CHECK(&a.getName() == &c.getName());
+  CHECK(std::hash<boss::Symbol>{}(a) == std::hash<boss::Symbol>{}(b));
+  CHECK(a != boss::Symbol("As"));
+  CHECK(a.getID() != boss::Symbol("As").getID());
+  CHECK("Column"_().getHead() == a);
+  CHECK("Column"_().getHead().getID() == a.getID());
+}
+
+TEST_CASE("Expressions hash structurally", "[expressions]") {
+  auto const hash = [](auto const& e) { return std::hash<std::decay_t<decltype(e)>>{}(e); };
+  auto const e = "Plus"_("Times"_(1, 2.5), "x"_, "y");
+  CHECK(hash(e) == hash("Plus"_("Times"_(1, 2.5), "x"_, "y")));
+  CHECK(hash(e) != hash("Plus"_("Times"_(2.5, 1), "x"_, "y")));
+  CHECK(hash(e) != hash("Plus"_("Times"_(1, 2.5), "y"_, "x")));
+  CHECK(hash(e) != hash("Minus"_("Times"_(1, 2.5), "x"_, "y")));
+  CHECK(hash(boss::Expression("x"_)) != hash(boss::Expression("x"s)));
+  CHECK(hash(boss::Expression(e.clone())) == hash(e));
+
+  SECTION("Equal expressions hash equally no matter how their arguments are stored") {
+    auto const dynamic = "List"_(int64_t(1), int64_t(2), int64_t(3));
+    auto spans = boss::expressions::ExpressionSpanArguments();
+    spans.emplace_back(boss::Span<int64_t>(vector<int64_t>{2, 3}));
+    auto const withSpans = boss::ComplexExpression(
+        "List"_, {}, boss::ExpressionArguments(int64_t(1)), std::move(spans));
+    auto const withStatics =
+        boss::ComplexExpressionWithStaticArguments<int64_t, int64_t, int64_t>("List"_, {1, 2, 3});
+    REQUIRE(dynamic == withSpans);
+    CHECK(hash(dynamic) == hash(withSpans));
+    CHECK(hash(dynamic) == hash(withStatics));
+    CHECK(hash("List"_(0.0)) == hash("List"_(-0.0)));
+  }
+
+  SECTION("Cached hashes are dropped when the arguments are modified") {
+    boss::ComplexExpression modified = "Plus"_(int64_t(1), int64_t(2));
+    auto const original = hash(modified);
+    get<int64_t>(modified.getArguments().at(0))++;
+    CHECK(hash(modified) != original);
+    CHECK(hash(modified) == hash("Plus"_(int64_t(2), int64_t(2))));
+    CHECK_FALSE(modified == "Plus"_(int64_t(1), int64_t(2)));
+    CHECK(modified == "Plus"_(int64_t(2), int64_t(2)));
+  }
+
+  SECTION("Hashes are not cached while the arguments can be modified") {
+    boss::ComplexExpression modified = "Plus"_(int64_t(1), int64_t(2));
+    {
+      auto arguments = modified.getArguments();
+      hash(modified);
+      get<int64_t>(arguments.at(0)) = 5;
+      CHECK(hash(modified) == hash("Plus"_(int64_t(5), int64_t(2))));
+      CHECK(modified == "Plus"_(int64_t(5), int64_t(2)));
+    }
+    CHECK(hash(modified) == hash("Plus"_(int64_t(5), int64_t(2))));
+    CHECK(modified == "Plus"_(int64_t(5), int64_t(2)));
+  }
+
+  SECTION("Expressions can be used as keys of unordered containers") {
+    auto set = std::unordered_set<boss::ComplexExpression>();
+    set.insert("Plus"_(1, 2));
+    set.insert("Plus"_(1, 2));
+    set.insert("Plus"_(2, 1));
+    CHECK(set.size() == 2);
+    CHECK(set.count("Plus"_(2, 1)) == 1);
+  }
+}
+
+TEST_CASE("Dates", "[expressions]") {
+  auto const date = boss::Date("1998-08-31");
+  CHECK(date.getDaysSinceEpoch() == 10469); // NOLINT
+  CHECK(date == boss::Date(1998, 8, 31));   // NOLINT
+  CHECK(date.toString() == "1998-08-31");
+  CHECK(boss::Date(0).toString() == "1970-01-01");
+  CHECK(boss::Date(-1).toString() == "1969-12-31");
+  CHECK(boss::Date("2000-02-29").toString() == "2000-02-29");
+  CHECK(boss::Date("1992-03-13") < date);
+  CHECK(date > boss::Date("1998-08-30"));
+  CHECK_THROWS_AS(boss::Date("1999-02-29"), std::invalid_argument);
+  CHECK_THROWS_AS(boss::Date("1998-8-31"), std::invalid_argument);
+  CHECK_THROWS_AS(boss::Date("yesterday!"), std::invalid_argument);
+
+  auto const expression = boss::Expression(date);
+  CHECK(expression == date);
+  CHECK(get<boss::Date>(expression) == date);
+  auto output = std::stringstream();
+  output << expression;
+  CHECK(output.str() == "DateObject[\"1998-08-31\"]");
+
+  SECTION("DateObjects are converted to dates (and columns of dates to spans)") {
+    auto converted = boss::utilities::convertDateObjects(
+        "Select"_("Column"_("L_SHIPDATE"_, "List"_("DateObject"_("1992-03-13"),
+                                                   "DateObject"_("1994-04-12"))),
+                  "Where"_("Greater"_("DateObject"_("1998-08-31"), "L_SHIPDATE"_))));
+    auto const& select = get<boss::ComplexExpression>(converted);
+    auto const& column = get<boss::ComplexExpression>(select.getArguments().at(0));
+    auto const& list = get<boss::ComplexExpression>(column.getArguments().at(1));
+    CHECK(list.getDynamicArguments().empty());
+    REQUIRE(list.getSpanArguments().size() == 1);
+    auto const& dates = std::get<boss::Span<boss::Date>>(list.getSpanArguments()[0]);
+    CHECK(dates[0] == boss::Date("1992-03-13"));
+    CHECK(dates[1] == boss::Date("1994-04-12"));
+    CHECK(list.getArguments().at(1) == boss::Date("1994-04-12"));
+    CHECK(converted == "Select"_("Column"_("L_SHIPDATE"_, "List"_(boss::Date("1992-03-13"),
+                                                                  boss::Date("1994-04-12"))),
+                                "Where"_("Greater"_(date, "L_SHIPDATE"_))));
+  }
+}
+
+TEST_CASE("Decimals", "[expressions]") {
+  auto const price = boss::Decimal("901.5");
+  CHECK(price.getUnscaledValue() == 9015000); // NOLINT
+  CHECK(price.toString() == "901.5000");
+  CHECK(boss::Decimal("-0.05").toString() == "-0.0500");
+  CHECK(boss::Decimal("-0.05") == -boss::Decimal("0.05"));
+  CHECK(boss::Decimal("12") == boss::Decimal::fromUnscaledValue(120000)); // NOLINT
+  CHECK(boss::Decimal("0.1") < boss::Decimal("0.11"));
+  CHECK_THROWS_AS(boss::Decimal("0.00001"), std::invalid_argument);
+  CHECK_THROWS_AS(boss::Decimal("1e3"), std::invalid_argument);
+  CHECK_THROWS_AS(boss::Decimal(".5"), std::invalid_argument);
+  CHECK_THROWS_AS(boss::Decimal("123456789012345"), std::invalid_argument);
+
+  SECTION("Arithmetic") {
+    CHECK(price + boss::Decimal("0.25") == boss::Decimal("901.75"));
+    CHECK(price - boss::Decimal("1000") == boss::Decimal("-98.5"));
+    CHECK(price * (boss::Decimal("1") - boss::Decimal("0.06")) == boss::Decimal("847.41"));
+    CHECK(boss::Decimal("0.0001") * boss::Decimal("0.5") == boss::Decimal("0.0001"));
+    CHECK(boss::Decimal("0.0001") * boss::Decimal("0.4999") == boss::Decimal("0"));
+    CHECK(boss::Decimal("-0.0001") * boss::Decimal("0.5") == boss::Decimal("-0.0001"));
+    CHECK(boss::Decimal("-1.0001") * boss::Decimal("-0.5") == boss::Decimal("0.5001"));
+    CHECK(boss::Decimal("-123456.78") * boss::Decimal("98765.4321") ==
+          boss::Decimal("-12193262222.3746"));
+    auto const largest = boss::Decimal::fromUnscaledValue(INT64_MAX);
+    CHECK(!largest.sumOverflows(boss::Decimal()));
+    CHECK(largest.sumOverflows(boss::Decimal("0.0001")));
+    CHECK(largest + boss::Decimal("0.0001") == boss::Decimal::fromUnscaledValue(INT64_MIN));
+    CHECK(boss::Decimal("1").differenceOverflows(-largest));
+    CHECK(!boss::Decimal("-0.0001").differenceOverflows(largest));
+    CHECK(boss::Decimal().differenceOverflows(boss::Decimal::fromUnscaledValue(INT64_MIN)));
+    CHECK(!boss::Decimal("-123456.78").productOverflows(boss::Decimal("98765.4321")));
+    CHECK(largest.productOverflows(boss::Decimal("1.0001")));
+    CHECK(!largest.productOverflows(boss::Decimal("1")));
+    CHECK(largest * boss::Decimal("1") == largest);
+  }
+
+  SECTION("Expressions") {
+    auto const expression = boss::Expression(price);
+    CHECK(expression == price);
+    CHECK(get<boss::Decimal>(expression) == price);
+    CHECK(expression.hash() == boss::Expression(boss::Decimal("901.50")).hash());
+    auto output = std::stringstream();
+    output << "Plus"_(price, "L_TAX"_);
+    CHECK(output.str() == "Plus[901.5000,L_TAX]");
+  }
+
+  SECTION("Columns") {
+    auto tenths = std::vector<boss::Decimal>(1000, boss::Decimal("0.1"));     // NOLINT
+    auto discounts = std::vector<boss::Decimal>(1000, boss::Decimal("0.06")); // NOLINT
+    discounts.back() = boss::Decimal("-1");
+    auto const left = boss::Span<boss::Decimal const>(tenths);
+    auto const right = boss::Span<boss::Decimal>(std::move(discounts));
+    CHECK(boss::algorithm::sum(left) == boss::Decimal("100"));
+    CHECK(boss::algorithm::sum(right) == boss::Decimal("58.94"));
+    auto differences = boss::Span<boss::Decimal>(std::vector<boss::Decimal>(1000)); // NOLINT
+    boss::algorithm::minus(left, right, differences);
+    CHECK(differences[0] == boss::Decimal("0.04"));
+    CHECK(differences[999] == boss::Decimal("1.1")); // NOLINT
+    auto products = boss::Span<boss::Decimal>(std::vector<boss::Decimal>(1000)); // NOLINT
+    boss::algorithm::times(left, right, products, boss::algorithm::IntegerOverflow::Check);
+    CHECK(products[0] == boss::Decimal("0.006"));
+    auto sums = boss::Span<boss::Decimal>(std::vector<boss::Decimal>(1000)); // NOLINT
+    boss::algorithm::plus(left, right, sums);
+    CHECK(boss::algorithm::sum(sums) == boss::Decimal("158.94"));
+    boss::algorithm::minus(boss::Decimal("1"), right, sums);
+    CHECK(sums[0] == boss::Decimal("0.94"));
+
+    auto const extremes = std::vector<boss::Decimal>{
+        boss::Decimal::fromUnscaledValue(INT64_MAX), boss::Decimal::fromUnscaledValue(INT64_MAX),
+        boss::Decimal::fromUnscaledValue(INT64_MIN), boss::Decimal::fromUnscaledValue(-2)};
+    auto const extremeSpan = boss::Span<boss::Decimal const>(extremes);
+    CHECK_THROWS_AS(boss::algorithm::plus(left, extremeSpan, sums), std::invalid_argument);
+    auto wrapped = boss::Span<boss::Decimal>(std::vector<boss::Decimal>(extremes.size()));
+    boss::algorithm::plus(extremeSpan, extremeSpan, wrapped);
+    CHECK(wrapped[0] == boss::Decimal::fromUnscaledValue(-2));
+    CHECK(wrapped[2] == boss::Decimal());
+    using boss::algorithm::IntegerOverflow;
+    CHECK_THROWS_AS(boss::algorithm::plus(extremeSpan, extremeSpan, wrapped,
+                                          IntegerOverflow::Check),
+                    std::overflow_error);
+    CHECK_THROWS_AS(boss::algorithm::minus(boss::Decimal(), extremeSpan, wrapped,
+                                           IntegerOverflow::Check),
+                    std::overflow_error);
+    CHECK_THROWS_AS(boss::algorithm::times(extremeSpan, boss::Decimal("2"), wrapped,
+                                           IntegerOverflow::Check),
+                    std::overflow_error);
+    CHECK(boss::algorithm::sum(boss::Span<boss::Decimal const>(extremes)) ==
+          boss::Decimal::fromUnscaledValue(INT64_MAX - 3));
+    auto const withMissing =
+        boss::Span<boss::Decimal const>(extremes)
+            .withValidity(boss::expressions::ValidityBitmap({true, false, true, true}));
+    CHECK(boss::algorithm::sum(withMissing) == boss::Decimal::fromUnscaledValue(-3));
+    auto const tooLarge =
+        std::vector<boss::Decimal>(2, boss::Decimal::fromUnscaledValue(INT64_MAX));
+    CHECK_THROWS_AS(boss::algorithm::sum(boss::Span<boss::Decimal const>(tooLarge)),
+                    std::overflow_error);
+  }
+}
+
 class DummyAtom {
 public:
   friend std::ostream& operator<<(std::ostream& s, DummyAtom const& /*unused*/) {
@@ -158,6 +439,41 @@ public:
   }
 };
 
+TEST_CASE("Shared expressions are cloned without copying", "[expressions][clone]") {
+  auto spans = boss::expressions::ExpressionSpanArguments();
+  spans.emplace_back(boss::Span<int64_t>(vector<int64_t>{1, 2, 3}));
+  auto column = boss::ComplexExpression("Column"_, {}, boss::ExpressionArguments("x"_),
+                                        std::move(spans));
+  auto const shared =
+      boss::ComplexExpression("Table"_, boss::ExpressionArguments(std::move(column), int64_t(1)))
+          .share();
+  CHECK(shared.isShared());
+  auto const& sharedColumn = get<boss::ComplexExpression>(shared.getDynamicArguments()[0]);
+  CHECK(sharedColumn.isShared());
+
+  auto clone = shared.clone(CloneReason::FOR_TESTING);
+  CHECK(clone == shared);
+  CHECK(&clone.getDynamicArguments() == &shared.getDynamicArguments());
+  auto const hash = std::hash<boss::ComplexExpression>{};
+  CHECK(hash(clone) == hash(shared));
+
+  // copy-on-write: the clone takes its own copy of the arguments (but the column is still shared)
+  get<int64_t>(clone.getArguments()[1]) = 2;
+  CHECK(!clone.isShared());
+  CHECK(clone != shared);
+  CHECK(get<int64_t>(shared.getDynamicArguments()[1]) == 1);
+  auto const& clonedColumn = get<boss::ComplexExpression>(clone.getDynamicArguments()[0]);
+  CHECK(clonedColumn.isShared());
+  CHECK(&clonedColumn.getSpanArguments() == &sharedColumn.getSpanArguments());
+
+  // the last owner takes the arguments back without copying them
+  auto onlyOwner = std::move(clone).share();
+  auto const* const arguments = &onlyOwner.getDynamicArguments()[0];
+  onlyOwner.getArguments();
+  CHECK(!onlyOwner.isShared());
+  CHECK(&onlyOwner.getDynamicArguments()[0] == arguments);
+}
+
 TEST_CASE("Expression cast to more general expression system", "[expressions]") {
   auto a = boss::ExtensibleExpressionSystem<>::Expression("howdie"_());
   auto b = (boss::ExtensibleExpressionSystem<DummyAtom>::Expression)std::move(a);
@@ -199,7 +515,10 @@ TEST_CASE("Extract typed arguments from complex expression (using std::accumulat
                            [](boss::ExtensibleExpressionSystem<DummyAtom>::ComplexExpression const&
                                   expr) { return expr.getHead().getName(); },
                            [](boss::Symbol const& symbol) { return symbol.getName(); },
-                           [](std::string const& str) { return str; }),
+                           [](boss::Date const& date) { return date.toString(); },
+                           [](boss::Decimal const& decimal) { return decimal.toString(); },
+                           [](std::string const& str) { return str; },
+                           [](std::string_view str) { return string(str); }),
                        arg);
         });
   }(expr0);
@@ -224,7 +543,10 @@ TEST_CASE("Extract typed arguments from complex expression (manual iteration)",
                       return expr.getHead().getName();
                     },
                     [](boss::Symbol const& symbol) { return symbol.getName(); },
-                    [](std::string const& str) { return str; }),
+                    [](boss::Date const& date) { return date.toString(); },
+                    [](boss::Decimal const& decimal) { return decimal.toString(); },
+                    [](std::string const& str) { return str; },
+                    [](std::string_view str) { return string(str); }),
                 args.at(idx));
     }
     return accStr;
@@ -254,7 +576,10 @@ TEST_CASE("Merge two complex expressions", "[expressions]") {
                                     return expr.getHead().getName();
                                   },
                                   [](boss::Symbol const& symbol) { return symbol.getName(); },
-                                  [](std::string const& str) { return str; }),
+                                  [](boss::Date const& date) { return date.toString(); },
+                                  [](boss::Decimal const& decimal) { return decimal.toString(); },
+                                  [](std::string const& str) { return str; },
+                                  [](std::string_view str) { return string(str); }),
                               arg);
       });
   CHECK(str == "List_howdie_1_unknown_hello world");
@@ -282,7 +607,10 @@ TEST_CASE("Merge a static and a dynamic complex expressions", "[expressions]") {
                                     return expr.getHead().getName();
                                   },
                                   [](boss::Symbol const& symbol) { return symbol.getName(); },
-                                  [](std::string const& str) { return str; }),
+                                  [](boss::Date const& date) { return date.toString(); },
+                                  [](boss::Decimal const& decimal) { return decimal.toString(); },
+                                  [](std::string const& str) { return str; },
+                                  [](std::string_view str) { return string(str); }),
                               arg);
       });
   CHECK(str == "List_howdie_1_unknown_hello world");
@@ -312,6 +640,45 @@ TEST_CASE("get_if for complex expression's arguments", "[expressions]") {
   CHECK(arg0args.empty());
 }
 
+TEST_CASE("Complex expressions allocate exactly one argument buffer", "[expressions]") {
+  auto const& literal = "Greater"_("x"_, 3);
+  CHECK(literal.getDynamicArguments().capacity() == 2);
+  using StaticGreater = boss::ComplexExpressionWithStaticArguments<std::int64_t, std::int64_t>;
+  auto const staticExpression = StaticGreater("Greater"_, {1, 3}, {}, {});
+  boss::ComplexExpression const dynamic = staticExpression;
+  CHECK(dynamic.getDynamicArguments().size() == 2);
+  CHECK(dynamic.getDynamicArguments().capacity() == 2);
+  auto const& list = "List"_("howdie"_(), 1, "unknown"_, "hello world"s);
+  CHECK(list.getDynamicArguments().capacity() == 4);
+  auto const& cloned = list.clone(CloneReason::FOR_TESTING);
+  CHECK(cloned.getDynamicArguments().capacity() == 4);
+  auto const& arguments = boss::ExpressionArguments(1, 2L, 3.0);
+  CHECK(arguments.capacity() == 3);
+}
+
+TEST_CASE("Expressions can be built in an arena and relocated out of it", "[expressions]") {
+  auto buffer = std::array<std::byte, 1U << 16U>();
+  auto const isInArena = [&buffer](void const* pointer) {
+    return pointer >= buffer.data() && pointer < buffer.data() + buffer.size();
+  };
+  auto arena = std::pmr::monotonic_buffer_resource(buffer.data(), buffer.size(),
+                                                   std::pmr::null_memory_resource());
+  auto built = [&arena] {
+    auto const scope = boss::expressions::ScopedExpressionMemoryResource(&arena);
+    return "Select"_("Project"_("Table"_(), "As"_("x"_, "A"_)), "Where"_("Greater"_("x"_, 3)));
+  }();
+  CHECK(isInArena(built.getDynamicArguments().data()));
+  auto relocated = std::move(built).relocate();
+  CHECK(!isInArena(relocated.getDynamicArguments().data()));
+  CHECK(relocated ==
+        "Select"_("Project"_("Table"_(), "As"_("x"_, "A"_)), "Where"_("Greater"_("x"_, 3))));
+
+  auto engine = boss::engines::BootstrapEngine();
+  engine.evaluate("UseExpressionArena"_(true));
+  auto evaluated = engine.evaluate("Select"_("Table"_(), "Where"_("Greater"_("x"_, 3))));
+  CHECK(evaluated == "Select"_("Table"_(), "Where"_("Greater"_("x"_, 3))));
+}
+
 TEST_CASE("move expression's arguments to a new expression", "[expressions]") {
   auto expr = "List"_("howdie"_(), 1, "unknown"_, "hello world"s);
   auto&& movedExpr = std::move(expr);
@@ -441,6 +808,704 @@ TEMPLATE_TEST_CASE("Complex Expressions with Spans", "[spans]", std::string, bos
   }
 }
 
+TEST_CASE("String spans store their characters contiguously", "[spans]") {
+  using std::literals::string_view_literals::operator""sv;
+  auto const strings = vector<string>{"hello", "", "a string that is too long for SSO"};
+  auto span = boss::Span<std::string_view>(strings);
+  REQUIRE(span.size() == 3);
+  CHECK(span[0] == "hello");
+  CHECK(span[1].empty());
+  CHECK(span.at(2) == strings[2]);
+  CHECK_THROWS_AS(span.at(3), std::out_of_range);
+  CHECK(span.characterData() == "helloa string that is too long for SSO");
+  CHECK(span[2].data() == span.characterData().data() + 5);
+  CHECK(vector<std::string_view>(span.begin(), span.end()) ==
+        vector<std::string_view>{"hello", "", strings[2]});
+
+  SECTION("Zero-copy construction from loaded buffers") {
+    auto destructorCalls = 0;
+    {
+      static constexpr auto characters = "N_NAMEALGERIAARGENTINA"sv;
+      static constexpr auto offsets = std::array<int64_t, 4>{6, 13, 13, 22};
+      auto loaded = boss::Span<std::string_view>(characters.data(), offsets.data(), 3,
+                                                 [&destructorCalls]() { destructorCalls++; });
+      CHECK(loaded[0] == "ALGERIA");
+      CHECK(loaded[2] == "ARGENTINA");
+      CHECK(loaded[0].data() == characters.data() + 6);
+      auto const copy = loaded.clone(CloneReason::FOR_TESTING);
+      CHECK(copy[2] == "ARGENTINA");
+      CHECK(copy.characterData().data() != characters.data() + 6);
+      auto const shared = std::move(loaded).share();
+      CHECK(shared.clone(CloneReason::FOR_TESTING).characterData().data() ==
+            characters.data() + 6);
+      auto const tail = shared.clone(CloneReason::FOR_TESTING).subspan(1);
+      CHECK(tail.size() == 2);
+      CHECK(tail[1] == "ARGENTINA");
+      CHECK(destructorCalls == 0);
+    }
+    CHECK(destructorCalls == 1);
+  }
+
+  SECTION("String spans in expressions") {
+    auto spans = boss::expressions::ExpressionSpanArguments();
+    spans.emplace_back(std::move(span));
+    auto const expression = boss::ComplexExpression("List"_, {}, {}, std::move(spans));
+    auto const& arguments = expression.getArguments();
+    CHECK(get<std::string_view>(arguments.at(0)) == "hello");
+    CHECK(holds_alternative<std::string_view>(arguments.at(2)));
+    CHECK(arguments.at(2) == strings[2]);
+    CHECK(expression.cloneArgument(0, CloneReason::FOR_TESTING) == "hello"s);
+
+    boss::ComplexExpression const dynamic = "List"_("hello"s, ""s, strings[2]);
+    auto const vectorOfStrings =
+        "List"_(boss::Span<string>(vector<string>(strings.begin(), strings.end())));
+    CHECK(expression == dynamic);
+    CHECK(expression == vectorOfStrings);
+    CHECK(expression.hash() == dynamic.hash());
+    CHECK(expression.clone(CloneReason::FOR_TESTING) == expression);
+    CHECK(expression != boss::ComplexExpression("List"_("hello"s, ""s, "other"s)));
+
+    auto output = std::stringstream();
+    output << expression;
+    CHECK(output.str() == "List[hello,,a string that is too long for SSO]");
+
+    auto visited = vector<std::string_view>();
+    expression.visitChunks([&visited](auto const* data, size_t n) {
+      if constexpr(std::is_same_v<std::decay_t<decltype(*data)>, std::string_view>) {
+        visited.insert(visited.end(), data, data + n);
+      }
+    });
+    CHECK(visited.size() == 3);
+    CHECK(visited[0] == "hello");
+  }
+}
+
+TEST_CASE("Dictionary-encoded spans store codes into a shared dictionary", "[spans]") {
+  auto const flags = vector<string>{"N", "R", "A", "N", "N", "R"};
+  auto span = boss::Span<boss::DictionaryEncoded>(flags);
+  REQUIRE(span.size() == flags.size());
+  CHECK(span.getDictionary().size() == 3);
+  CHECK(vector<int32_t>(span.codeData(), span.codeData() + span.size()) ==
+        vector<int32_t>{0, 1, 2, 0, 0, 1});
+  CHECK(span[1] == "R");
+  CHECK(span.at(5) == "R");
+  CHECK_THROWS_AS(span.at(6), std::out_of_range);
+  CHECK(vector<std::string_view>(span.begin(), span.end()) ==
+        vector<std::string_view>(flags.begin(), flags.end()));
+  CHECK(span.codeOf("A") == 2);
+  CHECK(!span.codeOf("B").has_value());
+
+  SECTION("Clones share the dictionary") {
+    auto const copy = span.clone(CloneReason::FOR_TESTING);
+    CHECK(copy.sharesDictionaryWith(span));
+    CHECK(copy.codeData() != span.codeData());
+    auto const shared = std::move(span).share();
+    CHECK(shared.clone(CloneReason::FOR_TESTING).codeData() == shared.codeData());
+    auto const tail = shared.clone(CloneReason::FOR_TESTING).subspan(4);
+    CHECK(tail.size() == 2);
+    CHECK(tail[1] == "R");
+  }
+
+  SECTION("Zero-copy construction from loaded codes") {
+    auto destructorCalls = 0;
+    {
+      static constexpr auto codes = std::array<int32_t, 4>{1, 1, 0, 1};
+      auto const loaded = boss::Span<boss::DictionaryEncoded>(
+          codes.data(), codes.size(), span.getSharedDictionary(),
+          [&destructorCalls]() { destructorCalls++; });
+      CHECK(loaded.sharesDictionaryWith(span));
+      CHECK(loaded[2] == "N");
+      CHECK(loaded.codeData() == codes.data());
+    }
+    CHECK(destructorCalls == 1);
+  }
+
+  SECTION("Dictionary-encoded spans in expressions") {
+    auto const list = [](auto&&... spans) {
+      auto spanArguments = boss::expressions::ExpressionSpanArguments();
+      (spanArguments.emplace_back(std::forward<decltype(spans)>(spans)), ...);
+      return boss::ComplexExpression("List"_, {}, {}, std::move(spanArguments));
+    };
+    auto const dictionary = span.getSharedDictionary();
+    auto const expression = list(std::move(span));
+    auto const& arguments = expression.getArguments();
+    CHECK(get<std::string_view>(arguments.at(0)) == "N");
+    CHECK(arguments.at(2) == "A"s);
+    CHECK(expression.cloneArgument(1, CloneReason::FOR_TESTING) == "R"s);
+
+    boss::ComplexExpression const dynamic = "List"_("N"s, "R"s, "A"s, "N"s, "N"s, "R"s);
+    CHECK(expression == dynamic);
+    CHECK(expression.hash() == dynamic.hash());
+    CHECK(expression == list(boss::Span<std::string_view>(flags)));
+    auto const encoded = [&dictionary](vector<int32_t> codes) {
+      return boss::Span<boss::DictionaryEncoded>(std::move(codes), dictionary);
+    };
+    CHECK(expression == list(encoded({0, 1, 2}), encoded({0, 0, 1})));
+    CHECK(expression != list(encoded({0, 1, 2, 0, 0, 0})));
+    CHECK(expression == list(boss::Span<boss::DictionaryEncoded>(flags))); // another dictionary
+    CHECK(expression.clone(CloneReason::FOR_TESTING) == expression);
+
+    auto output = std::stringstream();
+    output << expression;
+    CHECK(output.str() == "List[N,R,A,N,N,R]");
+  }
+}
+
+TEST_CASE("Encoded spans compress integer columns", "[spans]") {
+  auto const encoding = GENERATE(boss::Encoding::RunLength, boss::Encoding::FrameOfReference,
+                                 boss::Encoding::Delta);
+  auto values = vector<int64_t>(1000); // NOLINT
+  for(auto i = 0U; i < values.size(); i++) {
+    values[i] = int64_t(1000000 + i / 4 * 3); // NOLINT(*-magic-numbers) sorted, like order keys
+  }
+  values[500] = std::numeric_limits<int64_t>::min(); // NOLINT
+  values[501] = std::numeric_limits<int64_t>::max(); // NOLINT
+  auto const span = boss::Span<boss::Encoded<int64_t>>(values, encoding);
+  REQUIRE(span.size() == values.size());
+  CHECK(span.getEncoding() == encoding);
+  CHECK(span.encodedSize() < values.size() * sizeof(int64_t));
+  CHECK(vector<int64_t>(span.begin(), span.end()) == values);
+  CHECK(vector<int64_t>(std::make_reverse_iterator(span.end()),
+                        std::make_reverse_iterator(span.begin())) ==
+        vector<int64_t>(values.rbegin(), values.rend()));
+  auto randomAccessMatches = true;
+  for(auto i = size_t(0); i < values.size(); i++) {
+    auto const index = i * 389 % values.size(); // NOLINT(*-magic-numbers) a permutation
+    randomAccessMatches &= span[index] == values[index];
+  }
+  CHECK(randomAccessMatches);
+  CHECK(span.at(999) == values[999]);
+  CHECK_THROWS_AS(span.at(1000), std::out_of_range);
+  auto decoded = vector<int64_t>(300);
+  span.decode(450, decoded.size(), decoded.data());
+  CHECK(decoded == vector<int64_t>(values.begin() + 450, values.begin() + 750));
+
+  auto const tail = span.clone(CloneReason::FOR_TESTING).subspan(499, 3);
+  CHECK(vector<int64_t>(tail.begin(), tail.end()) ==
+        vector<int64_t>(values.begin() + 499, values.begin() + 502));
+
+  SECTION("Encoded spans in expressions") {
+    auto spans = boss::expressions::ExpressionSpanArguments();
+    spans.emplace_back(span.clone(CloneReason::FOR_TESTING));
+    auto const expression = boss::ComplexExpression("List"_, {}, {}, std::move(spans));
+    auto const& arguments = expression.getArguments();
+    CHECK(get<int64_t>(arguments.at(3)) == values[3]);
+    CHECK(holds_alternative<int64_t>(arguments.at(3)));
+    CHECK(arguments.at(501) == values[501]);
+    CHECK(expression.cloneArgument(4, CloneReason::FOR_TESTING) == values[4]);
+    auto const plain = "List"_(boss::Span<int64_t>(vector(values)));
+    CHECK(expression == plain);
+    CHECK(expression.hash() == plain.hash());
+    CHECK(expression.clone(CloneReason::FOR_TESTING) == expression);
+    auto visited = vector<int64_t>();
+    expression.visitChunks([&visited](auto const* data, size_t n) {
+      if constexpr(std::is_same_v<std::decay_t<decltype(*data)>, int64_t>) {
+        visited.insert(visited.end(), data, data + n);
+      }
+    });
+    CHECK(visited == values);
+  }
+
+  SECTION("Decoded elements cannot be modified") {
+    auto spans = boss::expressions::ExpressionSpanArguments();
+    spans.emplace_back(span.clone(CloneReason::FOR_TESTING));
+    auto expression = boss::ComplexExpression("List"_, {}, {}, std::move(spans));
+    auto arguments = expression.getArguments();
+    auto const element = arguments.at(3);
+    CHECK_THROWS_AS(get<int64_t>(element) = 42, std::logic_error); // NOLINT
+    CHECK_THROWS_AS(get_if<int64_t>(&element), std::logic_error);
+    CHECK(get<int64_t>(std::as_const(expression).getArguments().at(3)) == values[3]);
+  }
+
+  SECTION("32-bit encoded spans") {
+    auto quantities = vector<int32_t>(values.size());
+    for(auto i = 0U; i < quantities.size(); i++) {
+      quantities[i] = int32_t(i % 50 + 1); // NOLINT(*-magic-numbers)
+    }
+    quantities[500] = std::numeric_limits<int32_t>::min(); // NOLINT
+    quantities[501] = std::numeric_limits<int32_t>::max(); // NOLINT
+    auto narrow = boss::Span<boss::Encoded<int32_t>>(quantities, encoding);
+    CHECK(vector<int32_t>(narrow.begin(), narrow.end()) == quantities);
+    auto spans = boss::expressions::ExpressionSpanArguments();
+    spans.emplace_back(std::move(narrow));
+    auto const expression = boss::ComplexExpression("List"_, {}, {}, std::move(spans));
+    CHECK(get<int32_t>(expression.getArguments().at(501)) == quantities[501]);
+    auto visited = vector<int32_t>();
+    expression.visitChunks([&visited](auto const* data, size_t n) {
+      if constexpr(std::is_same_v<std::decay_t<decltype(*data)>, int32_t>) {
+        visited.insert(visited.end(), data, data + n);
+      }
+    });
+    CHECK(visited == quantities);
+  }
+}
+
+TEST_CASE("Word-packed boolean spans", "[spans]") {
+  auto flags = vector<bool>(200); // NOLINT
+  for(auto i = 0U; i < flags.size(); i++) {
+    flags[i] = i % 3 == 0;
+  }
+  auto const multiplesOf3 = boss::Span<boss::PackedBool>(flags);
+  for(auto i = 0U; i < flags.size(); i++) {
+    flags[i] = i % 2 == 0;
+  }
+  auto const even = boss::Span<boss::PackedBool>(flags);
+  REQUIRE(even.size() == 200);
+  CHECK(even[198]);
+  CHECK(!even.at(199));
+  CHECK_THROWS_AS(even.at(200), std::out_of_range);
+  CHECK(even.popcount() == 100);
+  CHECK(multiplesOf3.popcount() == 67);
+  CHECK((even & multiplesOf3).popcount() == 34);
+  CHECK((even | multiplesOf3).popcount() == 133);
+  CHECK((~even).popcount() == 100);
+  CHECK((~even)[199]);
+
+  auto selection = vector<size_t>();
+  (even & multiplesOf3).forEachSetBit([&selection](size_t i) { selection.push_back(i); });
+  REQUIRE(selection.size() == 34);
+  CHECK(selection[1] == 6);
+  CHECK(selection.back() == 198);
+
+  SECTION("Subspans are not word-aligned") {
+    auto const tail = even.clone(CloneReason::FOR_TESTING).subspan(63, 100); // NOLINT
+    CHECK(!tail[0]);
+    CHECK(tail[1]);
+    CHECK(tail.popcount() == 50);
+    auto const other = multiplesOf3.clone(CloneReason::FOR_TESTING).subspan(0, 100);
+    CHECK((tail & other).popcount() == 17);
+    CHECK(vector<bool>((tail | other).begin(), (tail | other).end()).size() == 100);
+    auto shifted = vector<size_t>();
+    (tail & other).forEachSetBit([&shifted](size_t i) { shifted.push_back(i); });
+    CHECK(shifted.front() == 3); // 66 in even and 3 in multiplesOf3
+  }
+
+  SECTION("Missing elements propagate") {
+    auto valid = vector<bool>(200, true); // NOLINT
+    valid[4] = false;
+    auto const withMissing = even.clone(CloneReason::FOR_TESTING)
+                                 .withValidity(boss::expressions::ValidityBitmap(valid));
+    CHECK((withMissing & multiplesOf3).nullCount() == 1);
+    CHECK(!(multiplesOf3 | withMissing).isValid(4));
+  }
+
+  SECTION("Word-packed boolean spans in expressions") {
+    auto spans = boss::expressions::ExpressionSpanArguments();
+    spans.emplace_back(even.clone(CloneReason::FOR_TESTING));
+    auto const expression = boss::ComplexExpression("List"_, {}, {}, std::move(spans));
+    auto const& arguments = expression.getArguments();
+    CHECK(get<bool>(arguments.at(0)));
+    CHECK(holds_alternative<bool>(arguments.at(1)));
+    CHECK(arguments.at(1) == false);
+    CHECK(expression.cloneArgument(2, CloneReason::FOR_TESTING) == true);
+    auto const plain = "List"_(boss::Span<bool>(vector(flags)));
+    CHECK(expression == plain);
+    CHECK(expression.hash() == plain.hash());
+    CHECK(expression.clone(CloneReason::FOR_TESTING) == expression);
+  }
+}
+
+TEST_CASE("Selection views defer materialization", "[spans]") {
+  auto const base = std::make_shared<boss::Span<int64_t> const>(
+      boss::Span<int64_t>(vector<int64_t>{10, 11, 12, 13, 14, 15})); // NOLINT
+  auto const view = boss::Span<boss::Selected<int64_t>>(base, vector<uint32_t>{1, 3, 4});
+  REQUIRE(view.size() == 3);
+  CHECK(view[1] == 13);
+  CHECK(&view[0] == &base->at(1)); // the base is not copied
+  CHECK_THROWS_AS(view.at(3), std::out_of_range);
+  CHECK_THROWS_AS(boss::Span<boss::Selected<int64_t>>(base, vector<uint32_t>{6}),
+                  std::out_of_range);
+  CHECK(std::accumulate(view.begin(), view.end(), int64_t()) == 38); // NOLINT
+  auto const materialized = view.materialize();
+  CHECK(vector<int64_t>(materialized.begin(), materialized.end()) ==
+        vector<int64_t>{11, 13, 14}); // NOLINT
+  CHECK(view.clone(CloneReason::FOR_TESTING).subspan(1)[0] == 13);
+
+  SECTION("Selecting by a boolean span") {
+    auto const selection =
+        boss::Span<boss::PackedBool>(vector<bool>{true, false, false, false, false, true});
+    auto const selected = boss::Span<boss::Selected<int64_t>>(base, selection);
+    REQUIRE(selected.size() == 2);
+    CHECK(selected[1] == 15);
+  }
+
+  SECTION("Missing elements of the base are missing in the view") {
+    auto valid = vector<bool>(6, true); // NOLINT
+    valid[3] = false;
+    auto const withMissing = std::make_shared<boss::Span<int64_t> const>(
+        base->clone(CloneReason::FOR_TESTING)
+            .withValidity(boss::expressions::ValidityBitmap(valid)));
+    auto const selected = boss::Span<boss::Selected<int64_t>>(withMissing, vector<uint32_t>{1, 3});
+    CHECK(selected.isValid(0));
+    CHECK(!selected.isValid(1));
+    CHECK(selected.materialize().nullCount() == 1);
+  }
+
+  SECTION("Selection views in expressions") {
+    auto spans = boss::expressions::ExpressionSpanArguments();
+    spans.emplace_back(view.clone(CloneReason::FOR_TESTING));
+    auto const expression = boss::ComplexExpression("List"_, {}, {}, std::move(spans));
+    CHECK(get<int64_t>(expression.getArguments().at(2)) == 14);
+    CHECK(holds_alternative<int64_t>(expression.getArguments().at(0)));
+    auto const plain = "List"_(int64_t(11), int64_t(13), int64_t(14)); // NOLINT
+    CHECK(expression == plain);
+    CHECK(expression.hash() == plain.hash());
+    auto sum = int64_t();
+    expression.visitChunks([&sum](auto const* data, size_t n) {
+      if constexpr(std::is_same_v<std::decay_t<decltype(*data)>, int64_t>) {
+        sum = std::accumulate(data, data + n, sum);
+      }
+    });
+    CHECK(sum == 38); // NOLINT
+  }
+}
+
+TEST_CASE("Generated spans produce their elements on demand", "[spans]") {
+  auto requests = std::make_shared<vector<std::pair<size_t, size_t>>>();
+  auto const span = boss::Span<boss::Generated<int64_t>>(
+      10000, [requests](size_t begin, size_t n, int64_t* output) { // NOLINT
+        requests->emplace_back(begin, n);
+        std::iota(output, output + n, int64_t(begin)); // NOLINT
+      });
+  REQUIRE(span.size() == 10000);
+  CHECK(requests->empty()); // nothing is produced up front
+  CHECK(span[42] == 42);
+  CHECK_THROWS_AS(span.at(10000), std::out_of_range);
+  auto const tail = span.clone(CloneReason::FOR_TESTING).subspan(9990); // NOLINT
+  CHECK(tail.materialize()[0] == 9990);
+  CHECK(vector<int64_t>(tail.begin(), tail.end()).back() == 9999);
+
+  SECTION("Generated spans in expressions are streamed") {
+    auto spans = boss::expressions::ExpressionSpanArguments();
+    spans.emplace_back(span.clone(CloneReason::FOR_TESTING));
+    auto const expression = boss::ComplexExpression("List"_, {}, {}, std::move(spans));
+    CHECK(get<int64_t>(expression.getArguments().at(7)) == 7);
+    CHECK(holds_alternative<int64_t>(expression.getArguments().at(7)));
+    requests->clear();
+    auto sum = int64_t();
+    auto largestChunk = size_t();
+    expression.visitChunks([&](auto const* data, size_t n) {
+      if constexpr(std::is_same_v<std::decay_t<decltype(*data)>, int64_t>) {
+        sum = std::accumulate(data, data + n, sum);
+        largestChunk = std::max(largestChunk, n);
+      }
+    });
+    CHECK(sum == int64_t(10000) * 9999 / 2); // NOLINT
+    // a block at a time, one producer call per block
+    CHECK(largestChunk <= boss::ComplexExpression::visitChunksBlockSize);
+    CHECK(requests->size() == (10000 + largestChunk - 1) / largestChunk); // NOLINT
+    auto values = vector<int64_t>(10000);                                 // NOLINT
+    std::iota(values.begin(), values.end(), int64_t());
+    auto materialized = boss::expressions::ExpressionSpanArguments();
+    materialized.emplace_back(span.materialize());
+    CHECK(boss::ComplexExpression("List"_, {}, {}, std::move(materialized)) ==
+          "List"_(boss::Span<int64_t>(vector<int64_t>(values))));
+    // generated elements are compared by their producer, not produced
+    requests->clear();
+    CHECK(expression == expression.clone(CloneReason::FOR_TESTING));
+    CHECK(expression != "List"_(boss::Span<int64_t>(std::move(values))));
+    CHECK(expression.hash() == expression.clone(CloneReason::FOR_TESTING).hash());
+    CHECK(requests->empty());
+  }
+
+  SECTION("Sequential sources") {
+    auto next = std::make_shared<double>();
+    auto const sequential = boss::Span<boss::Generated<double>>::sequential(
+        5, [next](double* output, size_t n) { // NOLINT
+          // a source that delivers small batches and has one element less than the span
+          n = std::min({n, size_t(2), size_t(4 - *next)}); // NOLINT
+          std::generate_n(output, n, [&next]() { return (*next)++; });
+          return n;
+        });
+    auto produced = vector<double>(3);
+    sequential.produce(1, 3, produced.data()); // skips the first element
+    CHECK(produced == vector<double>{1, 2, 3});
+    CHECK_THROWS_AS(sequential[0], std::logic_error);
+    CHECK_THROWS_AS(sequential[4], std::runtime_error); // the source ends early
+  }
+
+  SECTION("Hashing and comparing does not consume sequential sources") {
+    auto next = std::make_shared<int64_t>();
+    auto spans = boss::expressions::ExpressionSpanArguments();
+    spans.emplace_back(boss::Span<boss::Generated<int64_t>>::sequential(
+        3, [next](int64_t* output, size_t n) {
+          std::generate_n(output, n, [&next]() { return (*next)++; });
+          return n;
+        }));
+    auto const expression = boss::ComplexExpression("List"_, {}, {}, std::move(spans));
+    expression.hash();
+    CHECK(expression.clone(CloneReason::FOR_TESTING) == expression);
+    auto produced = vector<int64_t>();
+    expression.visitChunks([&produced](auto const* data, size_t n) {
+      if constexpr(std::is_same_v<std::decay_t<decltype(*data)>, int64_t>) {
+        produced.insert(produced.end(), data, data + n);
+      }
+    });
+    CHECK(produced == vector<int64_t>{0, 1, 2});
+  }
+}
+
+TEST_CASE("Spans with validity bitmaps", "[spans]") {
+  auto valid = vector<bool>(130, true); // NOLINT
+  valid[1] = valid[64] = valid[129] = false;
+  auto const validity = boss::expressions::ValidityBitmap(valid);
+  CHECK(validity.size() == valid.size());
+  CHECK(validity.nullCount() == 3);
+  CHECK(!validity.isValid(64));
+  CHECK(validity.isValid(65));
+  CHECK(validity.wordData()[0] == ~uint64_t(2));
+  CHECK(validity.slice(2, 100).nullCount() == 1);
+  CHECK(!validity.slice(60, 10).isValid(4));
+  CHECK(boss::expressions::ValidityBitmap().isValid(1000)); // NOLINT
+  CHECK_THROWS_AS(boss::expressions::ValidityBitmap(vector<uint64_t>{0}, 65), // NOLINT
+                  std::invalid_argument);
+
+  auto values = vector<int64_t>(valid.size());
+  std::iota(values.begin(), values.end(), 0);
+  auto span = boss::Span<int64_t>(vector(values)).withValidity(validity);
+  CHECK(span.nullCount() == 3);
+  CHECK(!span.isValid(1));
+  CHECK_THROWS_AS(boss::Span<int64_t>(vector<int64_t>{1}).withValidity(validity),
+                  std::invalid_argument);
+
+  SECTION("Validity propagates through clone, share and subspan") {
+    auto const copy = span.clone(CloneReason::FOR_TESTING);
+    CHECK(copy.nullCount() == 3);
+    CHECK(copy.getValidity().wordData() == validity.wordData());
+    auto const shared = std::move(span).share();
+    CHECK(!shared.clone(CloneReason::FOR_TESTING).isValid(129));
+    auto const tail = shared.clone(CloneReason::FOR_TESTING).subspan(64); // NOLINT
+    CHECK(tail.nullCount() == 2);
+    CHECK(!tail.isValid(0));
+    CHECK(tail.isValid(1));
+    auto strings = boss::Span<std::string_view>(vector<string>{"a", "b", "c"})
+                       .withValidity(boss::expressions::ValidityBitmap({true, false, true}))
+                       .subspan(1);
+    CHECK(!strings.isValid(0));
+    CHECK(strings.clone(CloneReason::FOR_TESTING).nullCount() == 1);
+    auto const flags = boss::Span<boss::DictionaryEncoded>(vector<string>{"A", "N", "A"})
+                           .withValidity(boss::expressions::ValidityBitmap({true, true, false}));
+    CHECK(std::move(flags.clone(CloneReason::FOR_TESTING)).share().nullCount() == 1);
+  }
+
+  SECTION("Missing elements in expressions") {
+    auto const list = [](auto&&... spans) {
+      auto spanArguments = boss::expressions::ExpressionSpanArguments();
+      (spanArguments.emplace_back(std::forward<decltype(spans)>(spans)), ...);
+      return boss::ComplexExpression("List"_, {}, {}, std::move(spanArguments));
+    };
+    auto const longs = [](vector<int64_t> values, vector<bool> const& valid) {
+      return boss::Span<int64_t>(std::move(values))
+          .withValidity(boss::expressions::ValidityBitmap(valid));
+    };
+    auto const expression = list(longs({1, 2, 3}, {true, false, true}));
+    // the values of missing elements do not matter
+    CHECK(expression == list(longs({1, 0, 3}, {true, false, true})));
+    CHECK(expression.hash() == list(longs({1, 0, 3}, {true, false, true})).hash());
+    CHECK(expression == list(longs({1}, {true}), longs({5, 3}, {false, true})));
+    CHECK(expression != list(longs({1, 2, 3}, {true, true, true})));
+    CHECK(expression != list(boss::Span<int64_t>(vector<int64_t>{1, 2, 3})));
+    CHECK(expression.hash() != list(boss::Span<int64_t>(vector<int64_t>{1, 2, 3})).hash());
+    CHECK(expression != boss::ComplexExpression("List"_(int64_t(1), int64_t(2), int64_t(3))));
+    CHECK(expression.clone(CloneReason::FOR_TESTING) == expression);
+  }
+}
+
+TEST_CASE("Complex Expressions with many Spans", "[spans]") {
+  auto spans = boss::expressions::ExpressionSpanArguments();
+  auto expected = vector<int64_t>();
+  for(auto i = 0; i < 1000; i++) { // NOLINT
+    auto values = vector<int64_t>(i % 4);
+    std::iota(values.begin(), values.end(), int64_t(expected.size()));
+    expected.insert(expected.end(), values.begin(), values.end());
+    spans.emplace_back(boss::Span<int64_t>(std::move(values)));
+  }
+  spans.emplace_back(boss::Span<bool>(vector<bool>{true, false}));
+  auto const expression =
+      boss::ComplexExpression("List"_, {}, boss::ExpressionArguments(1, 2), std::move(spans));
+  auto const& arguments = expression.getArguments();
+  REQUIRE(arguments.size() == 2 + expected.size() + 2);
+  CHECK(arguments.at(1) == 2);
+  auto i = 0U;
+  for(auto const& argument : arguments) {
+    if(i >= 2 && i < 2 + expected.size()) {
+      CHECK(argument == expected[i - 2]);
+    }
+    i++;
+  }
+  CHECK(i == arguments.size());
+  for(auto j = 0U; j < expected.size(); j += 97) { // NOLINT
+    CHECK(arguments.at(2 + j) == expected[j]);
+    CHECK(arguments[2 + j] == expected[j]);
+  }
+  CHECK(get<bool>(arguments.at(arguments.size() - 2)));
+  CHECK(!get<bool>(arguments.at(arguments.size() - 1)));
+  CHECK_THROWS_AS(arguments.at(arguments.size()), std::out_of_range);
+}
+
+TEST_CASE("Comparing Complex Expressions with Spans", "[spans]") {
+  auto const list = [](boss::ExpressionArguments dynamicArguments, auto... spans) {
+    auto spanArguments = boss::expressions::ExpressionSpanArguments();
+    (spanArguments.emplace_back(std::move(spans)), ...);
+    return boss::ComplexExpression("List"_, {}, std::move(dynamicArguments),
+                                   std::move(spanArguments));
+  };
+  auto const longs = [](vector<int64_t> values) { return boss::Span<int64_t>(std::move(values)); };
+  auto const doubles = [](vector<double_t> values) {
+    return boss::Span<double_t>(std::move(values));
+  };
+
+  SECTION("Spans are compared across different chunkings") {
+    auto const a = list(boss::ExpressionArguments(int64_t(1)), longs({2, 3}), longs({4, 5, 6}));
+    CHECK(a == list(boss::ExpressionArguments(), longs({1, 2}), longs({}), longs({3, 4, 5, 6})));
+    CHECK(a == list(boss::ExpressionArguments(int64_t(1), int64_t(2)), longs({3, 4, 5, 6})));
+    CHECK(a != list(boss::ExpressionArguments(), longs({1, 2, 3, 4, 5, 7})));
+    CHECK(a != list(boss::ExpressionArguments(), longs({0, 2, 3, 4, 5, 6})));
+  }
+
+  SECTION("Non-owning and const spans are compared by value") {
+    auto values = vector<int64_t>{1, 2, 3};
+    auto const constValues = vector<int64_t>{1, 2, 3};
+    CHECK(list(boss::ExpressionArguments(), boss::Span<int64_t>(values)) ==
+          list(boss::ExpressionArguments(), boss::Span<int64_t const>(constValues)));
+  }
+
+  SECTION("Floating point spans follow floating point equality") {
+    CHECK(list(boss::ExpressionArguments(), doubles({0.0, 1.5})) ==
+          list(boss::ExpressionArguments(), doubles({-0.0, 1.5})));
+    auto const nan = std::numeric_limits<double_t>::quiet_NaN();
+    CHECK(list(boss::ExpressionArguments(), doubles({nan})) !=
+          list(boss::ExpressionArguments(), doubles({nan})));
+    auto many = vector<double_t>(1000, 1.0); // NOLINT
+    auto other = many;
+    CHECK(list(boss::ExpressionArguments(), doubles(many)) ==
+          list(boss::ExpressionArguments(), doubles(other)));
+    other[999] = 2.0; // NOLINT
+    CHECK(list(boss::ExpressionArguments(), doubles(many)) !=
+          list(boss::ExpressionArguments(), doubles(other)));
+  }
+
+  SECTION("Bool and string spans") {
+    CHECK(list(boss::ExpressionArguments(), boss::Span<bool>(vector<bool>{true, false})) ==
+          list(boss::ExpressionArguments(true), boss::Span<bool>(vector<bool>{false})));
+    CHECK(list(boss::ExpressionArguments(), boss::Span<string>(vector<string>{"a", "b"})) !=
+          list(boss::ExpressionArguments(), boss::Span<string>(vector<string>{"a", "c"})));
+  }
+
+  SECTION("Differently typed spans are compared element by element") {
+    CHECK(list(boss::ExpressionArguments(), longs({1, 2})) ==
+          list(boss::ExpressionArguments(), doubles({1.0, 2.0})));
+    CHECK(list(boss::ExpressionArguments(), longs({1, 2})) !=
+          list(boss::ExpressionArguments(), doubles({1.0, 2.5})));
+  }
+}
+
+TEST_CASE("Visiting the arguments of an expression in chunks", "[spans]") {
+  auto spans = boss::expressions::ExpressionSpanArguments();
+  spans.emplace_back(boss::Span<int64_t>(vector<int64_t>{5, 6, 7}));
+  spans.emplace_back(boss::Span<double_t>(vector<double_t>{}));
+  spans.emplace_back(boss::Span<bool>(vector<bool>{true, false, true}));
+  auto const expression = boss::ComplexExpression(
+      "List"_, {}, boss::ExpressionArguments(1L, 2L, 3L, 4.5, "x"_, "y"_, "Plus"_(1, 2), 8L),
+      std::move(spans));
+  using Chunk = std::pair<std::string, size_t>;
+  auto chunks = vector<Chunk>();
+  auto int64Sum = int64_t(0);
+  auto boolCount = size_t(0);
+  expression.visitChunks(boss::utilities::overload(
+      [&](int64_t const* data, size_t n) {
+        chunks.emplace_back("int64", n);
+        int64Sum = std::accumulate(data, data + n, int64Sum);
+      },
+      [&](double_t const* /*data*/, size_t n) { chunks.emplace_back("double", n); },
+      [&](bool const* data, size_t n) {
+        chunks.emplace_back("bool", n);
+        boolCount += std::count(data, data + n, true);
+      },
+      [&](boss::Symbol const* data, size_t n) { chunks.emplace_back(data->getName(), n); },
+      [&](boss::ComplexExpression const* data, size_t n) {
+        chunks.emplace_back(data->getHead().getName(), n);
+      },
+      [&](auto const* /*data*/, size_t n) { chunks.emplace_back("other", n); }));
+  CHECK(chunks == vector<Chunk>{{"int64", 3}, {"double", 1}, {"x", 1}, {"y", 1}, {"Plus", 1},
+                                {"int64", 1}, {"int64", 3}, {"bool", 3}});
+  CHECK(int64Sum == 1 + 2 + 3 + 8 + 5 + 6 + 7);
+  CHECK(boolCount == 2);
+
+  SECTION("Visitors that take the validity skip missing elements") {
+    auto validSpans = boss::expressions::ExpressionSpanArguments();
+    validSpans.emplace_back(
+        boss::Span<int64_t>(vector<int64_t>{5, 6, 7})
+            .withValidity(boss::expressions::ValidityBitmap({true, false, true})));
+    auto const withMissing = boss::ComplexExpression("List"_, {}, boss::ExpressionArguments(1L),
+                                                     std::move(validSpans));
+    auto validSum = int64_t(0);
+    withMissing.visitChunks(boss::utilities::overload(
+        [&validSum](int64_t const* data, size_t n,
+                    boss::expressions::ValidityBitmap const& validity) {
+          for(auto i = size_t(0); i < n; i++) {
+            validSum += validity.isValid(i) ? data[i] : 0;
+          }
+        },
+        [](auto const* /*data*/, size_t /*n*/, auto const& /*validity*/) {}));
+    CHECK(validSum == 1 + 5 + 7);
+  }
+}
+
+namespace {
+class Calculator : public boss::EngineBase<Calculator> {
+public:
+  vector<std::string> calls;
+  Calculator() {
+    registerOperator<&Calculator::plusIntegers>("Plus"_);
+    registerOperator<&Calculator::plusDoubles>("Plus"_);
+    registerOperator<&Calculator::plus>("Plus"_);
+    registerOperator<&Calculator::count>("Count"_);
+  }
+  Expression plusIntegers(boss::ComplexExpressionWithStaticArguments<int64_t, int64_t>&& e) {
+    calls.emplace_back("plusIntegers");
+    return std::get<0>(e.getStaticArguments()) + std::get<1>(e.getStaticArguments());
+  }
+  Expression plusDoubles(boss::ComplexExpressionWithStaticArguments<double_t, double_t>&& e) {
+    calls.emplace_back("plusDoubles");
+    return std::get<0>(e.getStaticArguments()) + std::get<1>(e.getStaticArguments());
+  }
+  Expression plus(ComplexExpression&& e) { // any other arguments
+    calls.emplace_back("plus");
+    return std::move(e);
+  }
+  Expression count(ComplexExpression&& e) { return int64_t(e.getArguments().size()); }
+  Expression unknownOperator(ComplexExpression&& e) { return "Unknown"_(std::move(e)); }
+};
+} // namespace
+
+TEST_CASE("Engines dispatch operators by head and argument types", "[engines]") {
+  auto engine = Calculator();
+  CHECK(engine.evaluate(int64_t(5)) == int64_t(5));
+  CHECK(engine.evaluate("Plus"_(int64_t(1), int64_t(2))) == int64_t(3));
+  CHECK(engine.evaluate("Plus"_(1.5, 2.0)) == 3.5);
+  CHECK(engine.calls == vector<std::string>{"plusIntegers", "plusDoubles"});
+  engine.calls.clear();
+
+  SECTION("Arguments are evaluated bottom-up") {
+    CHECK(engine.evaluate("Plus"_("Plus"_(int64_t(1), int64_t(2)), "Count"_("x"_, "y"_))) ==
+          int64_t(5));
+    CHECK(engine.calls == vector<std::string>{"plusIntegers", "plusIntegers"});
+  }
+
+  SECTION("Shapes that match no typed operator fall through") {
+    CHECK(engine.evaluate("Plus"_(int64_t(1), 2.0)) == "Plus"_(int64_t(1), 2.0));
+    CHECK(engine.evaluate("Plus"_(int64_t(1), int64_t(2), int64_t(3))) ==
+          "Plus"_(int64_t(1), int64_t(2), int64_t(3)));
+    CHECK(engine.calls == vector<std::string>{"plus", "plus"});
+  }
+
+  SECTION("Heads without operators") {
+    CHECK(engine.evaluate("Times"_("Plus"_(int64_t(1), int64_t(2)))) ==
+          "Unknown"_("Times"_(int64_t(3))));
+  }
+}
+
 TEST_CASE("Basics", "[basics]") { // NOLINT
   auto engine = boss::engines::BootstrapEngine();
   REQUIRE(!librariesToTest.empty());
@@ -1360,8 +2425,553 @@ TEMPLATE_TEST_CASE("Summation of numeric Spans", "[spans]", std::int32_t, std::i
   }
 }
 
+namespace {
+/**
+ * The kernel tests run once for every instruction set the processor supports
+ */
+auto supportedInstructionSetsGenerator() {
+  using boss::algorithm::InstructionSet;
+  return Catch::Generators::filter(
+      boss::algorithm::isSupported,
+      Catch::Generators::from_range(std::array<InstructionSet, 4>{
+          InstructionSet::Portable, InstructionSet::SSE2, InstructionSet::AVX2,
+          InstructionSet::AVX512}));
+}
+
+/**
+ * The columns of the kernel tests have full blocks of 64 (and vectors) and a tail
+ */
+constexpr size_t kernelTestSize = 1000 + 37;
+
+/**
+ * a column of the kernel tests' size whose element i is T(generator(i))
+ */
+template <typename T, typename Generator> vector<T> kernelTestColumn(Generator&& generator) {
+  auto column = vector<T>();
+  column.reserve(kernelTestSize);
+  for(auto i = size_t(0); i < kernelTestSize; i++) {
+    column.push_back(T(generator(i)));
+  }
+  return column;
+}
+
+/**
+ * The primes that scramble the kernel test columns (see scrambledColumn): columns scrambled by
+ * different primes are uncorrelated
+ */
+constexpr std::int64_t firstPrime = 7919;
+constexpr std::int64_t secondPrime = 104729;
+
+/**
+ * a kernel test column of the values offset + (i * prime % range), in a scrambled order
+ */
+template <typename T>
+vector<T> scrambledColumn(std::int64_t prime, std::int64_t range, std::int64_t offset = 0) {
+  return kernelTestColumn<T>(
+      [=](size_t i) { return offset + std::int64_t(i) * prime % range; });
+}
+} // namespace
+
+TEMPLATE_TEST_CASE("Reduction kernels agree with a plain loop", "[spans]", std::int32_t,
+                   std::int64_t, std::float_t, std::double_t) {
+  using boss::algorithm::InstructionSet;
+  using boss::algorithm::Summation;
+  auto const values = scrambledColumn<TestType>(firstPrime, 1000, -500);
+  auto const valid = kernelTestColumn<bool>( // a few blocks are missing entirely
+      [](size_t i) { return i % 3 != 0 && i < 900; });
+  auto const instructionSet = GENERATE(supportedInstructionSetsGenerator());
+
+  SECTION("Without missing values") {
+    auto const span = boss::Span<TestType const>(values);
+    CHECK(boss::algorithm::count(span) == values.size());
+    CHECK(boss::algorithm::sum(span, Summation::Fast, instructionSet) ==
+          std::accumulate(values.begin(), values.end(), int64_t(0)));
+    CHECK(boss::algorithm::min(span, instructionSet) == TestType(-500)); // NOLINT
+    CHECK(boss::algorithm::max(span, instructionSet) == TestType(499));  // NOLINT
+    CHECK(*boss::algorithm::mean(span, Summation::Fast, instructionSet) ==
+          Catch::Detail::Approx(std::accumulate(values.begin(), values.end(), 0.0) /
+                                double(values.size())));
+  }
+
+  SECTION("With missing values") {
+    auto const span = boss::Span<TestType>(vector(values))
+                          .withValidity(boss::expressions::ValidityBitmap(valid));
+    auto expected = int64_t(0);
+    auto expectedMin = std::numeric_limits<TestType>::max();
+    for(auto i = 0U; i < values.size(); i++) {
+      if(valid[i]) {
+        expected += int64_t(values[i]);
+        expectedMin = std::min(expectedMin, values[i]);
+      }
+    }
+    CHECK(boss::algorithm::count(span) == size_t(std::count(valid.begin(), valid.end(), true)));
+    CHECK(boss::algorithm::sum(span, Summation::Fast, instructionSet) == expected);
+    CHECK(boss::algorithm::min(span, instructionSet) == expectedMin);
+    CHECK(!boss::algorithm::max(boss::Span<TestType>(vector(values))
+                                    .withValidity(boss::expressions::ValidityBitmap(
+                                        vector<bool>(values.size(), false))),
+                                instructionSet));
+  }
+
+  SECTION("Deterministic summation has the same bits with every instruction set") {
+    auto fractions = vector<TestType>(values.size());
+    for(auto i = 0U; i < fractions.size(); i++) {
+      fractions[i] = std::is_floating_point_v<TestType> ? TestType(1.0 / (i + 1)) : values[i];
+    }
+    auto const span = boss::Span<TestType const>(fractions);
+    CHECK(boss::algorithm::sum(span, Summation::Deterministic, instructionSet) ==
+          boss::algorithm::sum(span, Summation::Deterministic, InstructionSet::Portable));
+  }
+
+  if constexpr(std::is_floating_point_v<TestType>) {
+    SECTION("NaNs are skipped by min and max") {
+      auto const nan = std::numeric_limits<TestType>::quiet_NaN();
+      auto const infinity = std::numeric_limits<TestType>::infinity();
+      auto withNaNs = vector<TestType>(values.size(), nan);
+      withNaNs[700] = TestType(3); // NOLINT
+      CHECK(boss::algorithm::min(boss::Span<TestType const>(withNaNs), instructionSet) == 3);
+      CHECK(boss::algorithm::max(boss::Span<TestType const>(withNaNs), instructionSet) == 3);
+      withNaNs[701] = infinity; // NOLINT
+      CHECK(boss::algorithm::max(boss::Span<TestType const>(withNaNs), instructionSet) == infinity);
+      auto const onlyNaNs = vector<TestType>(values.size(), nan);
+      auto const onlyNaNsSpan = boss::Span<TestType const>(onlyNaNs);
+      CHECK(std::isnan(*boss::algorithm::min(onlyNaNsSpan, instructionSet)));
+      CHECK(std::isnan(*boss::algorithm::max(onlyNaNsSpan, instructionSet)));
+    }
+  }
+
+  if constexpr(std::is_same_v<TestType, std::int64_t>) {
+    SECTION("64-bit integers are summed exactly") {
+      auto const extremes = vector<int64_t>{INT64_MAX, INT64_MAX, INT64_MIN, -1};
+      CHECK(boss::algorithm::sum(boss::Span<int64_t const>(extremes), Summation::Fast,
+                                 instructionSet) == INT64_MAX - 2);
+      auto const tooLarge = vector<int64_t>(100, INT64_MAX); // NOLINT
+      CHECK_THROWS_AS(boss::algorithm::sum(boss::Span<int64_t const>(tooLarge), Summation::Fast,
+                                           instructionSet),
+                      std::overflow_error);
+      CHECK(*boss::algorithm::mean(boss::Span<int64_t const>(tooLarge), Summation::Fast,
+                                   instructionSet) == Catch::Detail::Approx(double(INT64_MAX)));
+    }
+  }
+}
+
+TEMPLATE_TEST_CASE("Comparison kernels produce selection bitmaps and vectors", "[spans]",
+                   std::int32_t, std::int64_t, std::float_t, std::double_t) {
+  using boss::algorithm::InstructionSet;
+  auto const left = scrambledColumn<TestType>(firstPrime, 100);
+  auto const right = scrambledColumn<TestType>(secondPrime, 100);
+  auto const valid = kernelTestColumn<bool>([](size_t i) { return i % 5 != 0; });
+  auto const instructionSet = GENERATE(supportedInstructionSetsGenerator());
+  auto const leftSpan = boss::Span<TestType const>(left);
+  auto const rightSpan = boss::Span<TestType const>(right);
+  auto const check = [&](auto const& result, auto&& expected) {
+    REQUIRE(result.size() == left.size());
+    for(auto i = 0U; i < left.size(); i++) {
+      INFO(i);
+      CHECK(result[i] == expected(i));
+    }
+  };
+
+  SECTION("Column against constant") {
+    auto const c = TestType(42); // NOLINT
+    check(boss::algorithm::filter(instructionSet,
+                                  boss::algorithm::compare(leftSpan, std::less<>(), c)),
+          [&](auto i) { return left[i] < c; });
+    check(boss::algorithm::filter(instructionSet,
+                                  boss::algorithm::compare(leftSpan, std::less_equal<>(), c)),
+          [&](auto i) { return left[i] <= c; });
+    check(boss::algorithm::filter(instructionSet,
+                                  boss::algorithm::compare(leftSpan, std::equal_to<>(), c)),
+          [&](auto i) { return left[i] == c; });
+    check(boss::algorithm::filter(instructionSet,
+                                  boss::algorithm::compare(leftSpan, std::not_equal_to<>(), c)),
+          [&](auto i) { return left[i] != c; });
+    check(boss::algorithm::filter(instructionSet,
+                                  boss::algorithm::compare(leftSpan, std::greater<>(), c)),
+          [&](auto i) { return left[i] > c; });
+    check(boss::algorithm::filter(instructionSet,
+                                  boss::algorithm::compare(leftSpan, std::greater_equal<>(), c)),
+          [&](auto i) { return left[i] >= c; });
+    check(boss::algorithm::filter(instructionSet, boss::algorithm::between(leftSpan, 10, 20)),
+          [&](auto i) { return left[i] >= 10 && left[i] <= 20; });
+  }
+
+  SECTION("Column against column") {
+    check(boss::algorithm::filter(instructionSet,
+                                  boss::algorithm::compare(leftSpan, std::less<>(), rightSpan)),
+          [&](auto i) { return left[i] < right[i]; });
+    check(boss::algorithm::filter(instructionSet,
+                                  boss::algorithm::compare(leftSpan, std::equal_to<>(), rightSpan)),
+          [&](auto i) { return left[i] == right[i]; });
+    CHECK_THROWS_AS(boss::algorithm::compare(leftSpan, std::less<>(),
+                                             boss::Span<TestType const>(right).subspan(1)),
+                    std::invalid_argument);
+  }
+
+  SECTION("Missing values satisfy no predicate") {
+    auto const withMissing = boss::Span<TestType>(vector(left))
+                                 .withValidity(boss::expressions::ValidityBitmap(valid));
+    check(boss::algorithm::filter(instructionSet,
+                                  boss::algorithm::compare(withMissing, std::less<>(), 50)),
+          [&](auto i) { return valid[i] && left[i] < 50; });
+  }
+
+  SECTION("Conjunctions are fused") {
+    auto const fused = boss::algorithm::filter(
+        instructionSet, boss::algorithm::compare(leftSpan, std::greater<>(), 30),
+        boss::algorithm::compare(leftSpan, std::less<>(), rightSpan),
+        boss::algorithm::between(rightSpan, 40, 90));
+    auto const separate =
+        boss::algorithm::filter(instructionSet,
+                                boss::algorithm::compare(leftSpan, std::greater<>(), 30)) &
+        boss::algorithm::filter(instructionSet,
+                                boss::algorithm::compare(leftSpan, std::less<>(), rightSpan)) &
+        boss::algorithm::filter(instructionSet, boss::algorithm::between(rightSpan, 40, 90));
+    CHECK(fused.getBits() == separate.getBits());
+
+    auto const selection = boss::algorithm::select(
+        instructionSet, boss::algorithm::compare(leftSpan, std::greater<>(), 30),
+        boss::algorithm::compare(leftSpan, std::less<>(), rightSpan),
+        boss::algorithm::between(rightSpan, 40, 90));
+    auto expected = vector<uint32_t>();
+    fused.forEachSetBit([&expected](size_t i) { expected.push_back(uint32_t(i)); });
+    CHECK(selection == expected);
+  }
+}
+
+TEST_CASE("Comparison kernels compare dates and decimals", "[spans]") {
+  auto const shipDates = scrambledColumn<boss::Date>(firstPrime, 800, 9000);
+  auto const receiptDates = scrambledColumn<boss::Date>(secondPrime, 800, 9000);
+  auto const discounts = kernelTestColumn<boss::Decimal>(
+      [](size_t i) { return boss::Decimal::fromUnscaledValue(std::int64_t(i % 11 * 100)); });
+  auto const shipDateSpan = boss::Span<boss::Date const>(shipDates);
+  auto const receiptDateSpan = boss::Span<boss::Date const>(receiptDates);
+  auto const discountSpan = boss::Span<boss::Decimal const>(discounts);
+  auto const startDate = boss::Date("1995-01-01");
+  auto const filtered = boss::algorithm::filter(
+      boss::algorithm::compare(shipDateSpan, std::greater_equal<>(), startDate),
+      boss::algorithm::compare(shipDateSpan, std::less<>(), receiptDateSpan),
+      boss::algorithm::between(discountSpan, boss::Decimal("0.05"), boss::Decimal("0.07")));
+  REQUIRE(filtered.size() == shipDates.size());
+  auto matches = size_t(0);
+  for(auto i = 0U; i < shipDates.size(); i++) {
+    auto const expected = shipDates[i] >= startDate && shipDates[i] < receiptDates[i] &&
+                          discounts[i] >= boss::Decimal("0.05") &&
+                          discounts[i] <= boss::Decimal("0.07");
+    matches += expected ? 1 : 0;
+    CHECK(filtered[i] == expected);
+  }
+  CHECK(matches > 0);
+}
+
+TEMPLATE_TEST_CASE("Arithmetic kernels promote their operands", "[spans]", std::int32_t,
+                   std::int64_t, std::float_t, std::double_t) {
+  using boss::algorithm::InstructionSet;
+  using boss::algorithm::IntegerOverflow;
+  using Result = boss::algorithm::Promoted<TestType, std::int64_t>;
+  auto const left = scrambledColumn<TestType>(firstPrime, 100);
+  auto const right = scrambledColumn<std::int64_t>(secondPrime, 9, 1); // never zero
+  auto const valid = kernelTestColumn<bool>([](size_t i) { return i % 5 != 0; });
+  auto const instructionSet = GENERATE(supportedInstructionSetsGenerator());
+  auto const leftSpan = boss::Span<TestType const>(left);
+  auto const rightSpan = boss::Span<std::int64_t const>(right);
+  auto output = boss::Span<Result>(vector<Result>(left.size()));
+  auto const check = [&](auto&& expected) {
+    for(auto i = 0U; i < left.size(); i++) {
+      INFO(i);
+      CHECK(output[i] == Result(expected(i)));
+    }
+  };
+
+  SECTION("Columns") {
+    boss::algorithm::plus(leftSpan, rightSpan, output, IntegerOverflow::Check, instructionSet);
+    check([&](auto i) { return Result(left[i]) + Result(right[i]); });
+    boss::algorithm::minus(leftSpan, rightSpan, output, IntegerOverflow::Check, instructionSet);
+    check([&](auto i) { return Result(left[i]) - Result(right[i]); });
+    boss::algorithm::times(leftSpan, rightSpan, output, IntegerOverflow::Check, instructionSet);
+    check([&](auto i) { return Result(left[i]) * Result(right[i]); });
+    boss::algorithm::divide(leftSpan, rightSpan, output, IntegerOverflow::Check, instructionSet);
+    check([&](auto i) { return Result(left[i]) / Result(right[i]); });
+    CHECK(output.nullCount() == 0);
+  }
+
+  SECTION("Constants") {
+    boss::algorithm::minus(1, leftSpan, output, IntegerOverflow::Wrap, instructionSet);
+    check([&](auto i) { return Result(1) - Result(left[i]); });
+    boss::algorithm::divide(rightSpan, TestType(2), output, IntegerOverflow::Wrap, instructionSet);
+    check([&](auto i) { return Result(right[i]) / Result(2); });
+  }
+
+  SECTION("Missing values") {
+    auto const missing = boss::Span<TestType const>(left).withValidity(
+        boss::expressions::ValidityBitmap(valid));
+    boss::algorithm::times(missing, rightSpan, output, IntegerOverflow::Wrap, instructionSet);
+    REQUIRE(output.nullCount() == left.size() / 5 + 1);
+    for(auto i = 0U; i < left.size(); i++) {
+      INFO(i);
+      CHECK(output.isValid(i) == valid[i]);
+    }
+  }
+
+  SECTION("Sizes") {
+    auto tooSmall = boss::Span<Result>(vector<Result>(left.size() - 1));
+    CHECK_THROWS_AS(boss::algorithm::plus(leftSpan, rightSpan, tooSmall), std::invalid_argument);
+    CHECK_THROWS_AS(boss::algorithm::plus(leftSpan,
+                                          boss::Span<std::int64_t const>(right).subspan(1), output),
+                    std::invalid_argument);
+  }
+}
+
+TEST_CASE("Integer arithmetic kernels detect overflow on request", "[spans]") {
+  using boss::algorithm::IntegerOverflow;
+  auto const extremes = vector<std::int64_t>{INT64_MAX, 1, INT64_MIN, 0};
+  auto const span = boss::Span<std::int64_t const>(extremes);
+  auto output = boss::Span<std::int64_t>(vector<std::int64_t>(extremes.size()));
+
+  boss::algorithm::plus(span, 1, output);
+  CHECK(output[0] == INT64_MIN); // wraps around
+  CHECK_THROWS_AS(boss::algorithm::plus(span, 1, output, IntegerOverflow::Check),
+                  std::overflow_error);
+  CHECK_THROWS_AS(boss::algorithm::minus(span, 1, output, IntegerOverflow::Check),
+                  std::overflow_error);
+  CHECK_THROWS_AS(boss::algorithm::times(span, 2, output, IntegerOverflow::Check),
+                  std::overflow_error);
+  CHECK_THROWS_AS(boss::algorithm::divide(span, -1, output, IntegerOverflow::Check),
+                  std::overflow_error);
+  CHECK_THROWS_AS(boss::algorithm::divide(1, span, output), std::domain_error);
+
+  // missing elements cannot overflow or divide by zero
+  auto const missing = boss::Span<std::int64_t const>(extremes)
+                           .withValidity(boss::expressions::ValidityBitmap(
+                               vector<bool>{false, true, false, false}));
+  boss::algorithm::plus(missing, 1, output, IntegerOverflow::Check);
+  CHECK(output[1] == 2);
+  boss::algorithm::divide(1, missing, output, IntegerOverflow::Check);
+  CHECK(output[1] == 1);
+
+  // 32-bit integers are promoted, so their products fit
+  auto const ints = vector<std::int32_t>{INT32_MAX, INT32_MIN};
+  auto const intSpan = boss::Span<std::int32_t const>(ints);
+  auto products = boss::Span<std::int64_t>(vector<std::int64_t>(ints.size()));
+  boss::algorithm::times(intSpan, intSpan, products, IntegerOverflow::Check);
+  CHECK(products[0] == std::int64_t(INT32_MAX) * INT32_MAX);
+  CHECK(products[1] == std::int64_t(INT32_MIN) * INT32_MIN);
+}
+
+TEST_CASE("Hash kernels hash key columns", "[spans]") {
+  using boss::algorithm::InstructionSet;
+  auto const size = kernelTestSize;
+  auto const orderKeys = kernelTestColumn<std::int64_t>([](size_t i) { return i / 4; });
+  auto const lineNumbers = kernelTestColumn<std::int32_t>([](size_t i) { return i % 4; });
+  auto const prices = kernelTestColumn<std::double_t>([](size_t i) { return double(i % 7) / 2; });
+  auto const flags = kernelTestColumn<std::string>(
+      [](size_t i) { return i % 3 == 0 ? "A" : (i % 3 == 1 ? "N" : "a longer flag"); });
+  auto const orderKey = boss::Span<std::int64_t const>(orderKeys);
+  auto const lineNumber = boss::Span<std::int32_t const>(lineNumbers);
+  auto const price = boss::Span<std::double_t const>(prices);
+  auto const flag = boss::Span<std::string const>(flags);
+  auto const instructionSet = GENERATE(supportedInstructionSetsGenerator());
+  auto const expected = boss::algorithm::hash(InstructionSet::Portable, orderKey, lineNumber, flag);
+  auto const hashes = boss::algorithm::hash(instructionSet, orderKey, lineNumber, flag);
+  REQUIRE(hashes.size() == size);
+  for(auto i = 0U; i < size; i++) {
+    INFO(i);
+    CHECK(hashes[i] == expected[i]);
+  }
+
+  SECTION("Equal keys have equal hashes") {
+    auto distinct = std::unordered_set<std::uint64_t>(hashes.begin(), hashes.end());
+    CHECK(distinct.size() == size); // the (order key, line number) pairs are distinct
+    auto const priceHashes = boss::algorithm::hash(instructionSet, price);
+    for(auto i = 7U; i < size; i++) {
+      CHECK(priceHashes[i] == priceHashes[i - 7]);
+    }
+    auto const longLineNumbers = vector<std::int64_t>(lineNumbers.begin(), lineNumbers.end());
+    auto const floatPrices = vector<std::float_t>(prices.begin(), prices.end());
+    auto const views = boss::Span<std::string_view>(flags);
+    auto const encoded = boss::Span<boss::DictionaryEncoded>(flags);
+    auto const alike = [&](auto const& a, auto const& b) {
+      auto const left = boss::algorithm::hash(instructionSet, a);
+      auto const right = boss::algorithm::hash(instructionSet, b);
+      return std::equal(left.begin(), left.end(), right.begin(), right.end());
+    };
+    CHECK(alike(lineNumber, boss::Span<std::int64_t const>(longLineNumbers)));
+    CHECK(alike(price, boss::Span<std::float_t const>(floatPrices)));
+    CHECK(alike(flag, views));
+    CHECK(alike(flag, encoded));
+    CHECK(!alike(orderKey, price));
+    auto const doubleOrderKeys = vector<std::double_t>(orderKeys.begin(), orderKeys.end());
+    CHECK(alike(orderKey, boss::Span<std::double_t const>(doubleOrderKeys)));
+    auto const signedZeros = vector<std::double_t>{0.0, -0.0, 0.5, -0.5};
+    auto const zeroHashes = boss::algorithm::hash(instructionSet,
+                                                  boss::Span<std::double_t const>(signedZeros));
+    CHECK(zeroHashes[0] == zeroHashes[1]);
+    CHECK(zeroHashes[2] != zeroHashes[3]);
+  }
+
+  SECTION("Extending the hashes with more columns") {
+    auto extended = boss::algorithm::hash(instructionSet, orderKey);
+    boss::algorithm::extendHash(instructionSet, extended, lineNumber);
+    boss::algorithm::extendHash(instructionSet, extended, flag);
+    CHECK(std::equal(extended.begin(), extended.end(), hashes.begin(), hashes.end()));
+    auto const swapped = boss::algorithm::hash(instructionSet, lineNumber, orderKey, flag);
+    CHECK(!std::equal(swapped.begin(), swapped.end(), hashes.begin(), hashes.end()));
+    auto tooSmall = boss::Span<std::uint64_t>(vector<std::uint64_t>(size - 1));
+    CHECK_THROWS_AS(boss::algorithm::extendHash(instructionSet, tooSmall, orderKey),
+                    std::invalid_argument);
+  }
+
+  SECTION("Missing values hash alike") {
+    auto valid = vector<bool>(size);
+    for(auto i = 0U; i < size; i++) {
+      valid[i] = i % 5 != 0; // NOLINT
+    }
+    auto const missing = boss::algorithm::hash(
+        instructionSet,
+        boss::Span<std::int64_t const>(orderKeys).withValidity(
+            boss::expressions::ValidityBitmap(valid)));
+    auto const present = boss::algorithm::hash(instructionSet, orderKey);
+    for(auto i = 0U; i < size; i++) {
+      INFO(i);
+      CHECK((missing[i] == missing[0]) == !valid[i]);
+      if(valid[i]) {
+        CHECK(missing[i] == present[i]);
+      }
+    }
+  }
+
+  SECTION("The high bits partition sequential keys evenly") {
+    constexpr auto partitionBits = 4U;
+    auto keys = vector<std::int64_t>(1U << 16U); // NOLINT
+    std::iota(keys.begin(), keys.end(), 0);
+    auto partitions = std::array<size_t, 1U << partitionBits>();
+    for(auto hash : boss::algorithm::hash(instructionSet, boss::Span<std::int64_t const>(keys))) {
+      partitions[hash >> (64U - partitionBits)]++;
+    }
+    for(auto partition : partitions) {
+      CHECK(partition > keys.size() / partitions.size() * 9 / 10);  // NOLINT
+      CHECK(partition < keys.size() / partitions.size() * 11 / 10); // NOLINT
+    }
+  }
+}
+
+TEST_CASE("Parallel algorithms do not depend on the number of threads", "[parallel]") {
+  auto values = vector<double_t>(1000000); // NOLINT: a few hundred morsels
+  for(auto i = 0U; i < values.size(); i++) {
+    values[i] = 1.0 / (1 + i % 1000); // NOLINT
+  }
+  auto const span = boss::Span<double_t const>(values);
+  auto const plus = [](double_t a, double_t b) { return a + b; };
+  auto const serialSum = [&] {
+    auto pool = boss::algorithm::ThreadPool(1);
+    return boss::algorithm::parallelAccumulate(span, 0.0, plus, plus, pool);
+  }();
+  CHECK(serialSum == Catch::Detail::Approx(std::accumulate(values.begin(), values.end(), 0.0)));
+
+  auto const threads =
+      GENERATE(range(size_t(1), size_t(std::max(4U, std::thread::hardware_concurrency())) + 1));
+  auto pool = boss::algorithm::ThreadPool(threads);
+  REQUIRE(pool.size() == threads);
+
+  SECTION("Accumulate") {
+    CHECK(boss::algorithm::parallelAccumulate(span, 0.0, plus, plus, pool) == serialSum);
+    CHECK(boss::algorithm::parallelAccumulate(boss::Span<double_t const>(), 0.0, plus, plus,
+                                              pool) == 0.0);
+  }
+
+  SECTION("Transform") {
+    auto output = boss::Span<double_t>(vector<double_t>(values.size()));
+    boss::algorithm::parallelTransform(
+        span, output, [](double_t value) { return value * 2; }, pool);
+    for(auto i = 0U; i < values.size(); i++) {
+      if(output[i] != values[i] * 2) {
+        FAIL(i);
+      }
+    }
+    auto tooSmall = boss::Span<double_t>(vector<double_t>(values.size() - 1));
+    CHECK_THROWS_AS(boss::algorithm::parallelTransform(
+                        span, tooSmall, [](double_t value) { return value; }, pool),
+                    std::invalid_argument);
+  }
+
+  SECTION("Visiting span arguments") {
+    auto spans = boss::expressions::ExpressionSpanArguments();
+    spans.emplace_back(boss::Span<int64_t>(vector<int64_t>{1, 2, 3}));
+    spans.emplace_back(boss::Span<double_t>(vector(values)));
+    auto const sum = boss::algorithm::parallelVisitAccumulate(
+        spans, 0.0,
+        [](double_t state, auto const& element) {
+          if constexpr(std::is_arithmetic_v<std::decay_t<decltype(element)>>) {
+            return state + double_t(element);
+          } else {
+            return state;
+          }
+        },
+        plus, pool);
+    CHECK(sum == 6 + serialSum);
+
+    auto output = boss::Span<double_t>(vector<double_t>(values.size() + 3));
+    boss::algorithm::parallelVisitTransform(
+        spans, output,
+        [](auto const& element) {
+          if constexpr(std::is_arithmetic_v<std::decay_t<decltype(element)>>) {
+            return double_t(element);
+          } else {
+            return 0.0;
+          }
+        },
+        pool);
+    CHECK(output[2] == 3);
+    CHECK(output[3] == values[0]);
+    CHECK(output[values.size() + 2] == values.back());
+  }
+
+  SECTION("Encoded and generated spans") {
+    auto keys = vector<int64_t>(values.size());
+    std::iota(keys.begin(), keys.end(), int64_t());
+    auto const keySum = int64_t(keys.size()) * int64_t(keys.size() - 1) / 2;
+    auto const add = [](int64_t a, int64_t b) { return a + b; };
+    auto const encoded = boss::Span<boss::Encoded<int64_t>>(keys, boss::Encoding::Delta);
+    CHECK(boss::algorithm::parallelAccumulate(encoded, int64_t(), add, add, pool) == keySum);
+    auto const generated = boss::Span<boss::Generated<int64_t>>(
+        keys.size(), [](size_t begin, size_t n, int64_t* output) {
+          std::iota(output, output + n, int64_t(begin)); // NOLINT
+        });
+    CHECK(boss::algorithm::parallelAccumulate(generated, int64_t(), add, add, pool) == keySum);
+    auto output = boss::Span<int64_t>(vector<int64_t>(keys.size()));
+    boss::algorithm::parallelTransform(
+        generated, output, [](int64_t key) { return key * 2; }, pool);
+    CHECK(output[keys.size() - 1] == int64_t(keys.size() - 1) * 2);
+    auto const sequential = boss::Span<boss::Generated<int64_t>>::sequential(
+        keys.size(), [next = int64_t()](int64_t* output, size_t n) mutable {
+          std::generate_n(output, n, [&next]() { return next++; });
+          return n;
+        });
+    CHECK_THROWS_AS(boss::algorithm::parallelAccumulate(sequential, int64_t(), add, add, pool),
+                    std::invalid_argument);
+  }
+
+  SECTION("Exceptions and nested jobs") {
+    CHECK_THROWS_AS(boss::algorithm::parallelAccumulate(
+                        span, 0.0,
+                        [](double_t state, double_t value) {
+                          if(value < 0.0011) { // NOLINT: the last element of each 1000
+                            throw std::runtime_error("too small");
+                          }
+                          return state + value;
+                        },
+                        plus, pool),
+                    std::runtime_error);
+    auto nested = std::atomic<size_t>(0);
+    pool.forEachMorsel(threads, [&](size_t /*unused*/) {
+      pool.forEachMorsel(10, [&](size_t /*unused*/) { nested++; }); // NOLINT
+    });
+    CHECK(nested == threads * 10);
+  }
+}
+
 TEST_CASE("Expression Serialization") {
-  auto const plans = std::array<boss::Expression, 8>{
+  auto const plans = std::array<boss::Expression, 10>{
       "Yo"_,
       "Howdie"_("Yo"_(5, 17, "duh"_(3)), "Five"_(6), 9, 1),
       "Howdie"_(1, 4, 9, "You"_(1, 3), 9, 3),
@@ -1395,6 +3005,8 @@ TEST_CASE("Expression Serialization") {
       "Table"_("Something"_(5, 17, "Sum"_(3, 9, 2)), "Else"_(6, "Date"_())),
       "Table"_(1, 5, 9),
       Expression(3),
+      "Where"_("Greater"_(boss::Date("1998-08-31"), "L_SHIPDATE"_)),
+      "Times"_("L_EXTENDEDPRICE"_, boss::Decimal("0.94")),
       "SetDefaultEnginePipeline"_(
           "/Users/hlgr/Temp/BOSSWolframEngine/Debug/libBOSSWolframEngine.so")};
   for(auto const& plan : plans) {
@@ -18,6 +18,38 @@ TEST_CASE("Build Expression", "[api]") {
   CHECK(secondArgument == 4);
 }
 
+TEST_CASE("Build expression, with dates", "[api]") {
+  auto input = (std::array{dateToNewBOSSExpression(10469)}); // NOLINT
+  auto* s = symbolNameToNewBOSSSymbol("UnevaluatedAsNoEngineIsSet");
+  auto* c = newComplexBOSSExpression(s, 1, input.data());
+  auto* res = BOSSEvaluate(c);
+  auto* result = getArgumentsFromBOSSExpression(res);
+  auto const typeID = getBOSSExpressionTypeID(result[0]);
+  auto const daysSinceEpoch = getDateValueFromBOSSExpression(result[0]);
+  freeBOSSSymbol(s);
+  freeBOSSExpression(res);
+  freeBOSSExpression(input[0]);
+  freeBOSSArguments(result);
+  CHECK(typeID == 8);
+  CHECK(daysSinceEpoch == 10469); // NOLINT
+}
+
+TEST_CASE("Build expression, with decimals", "[api]") {
+  auto input = (std::array{decimalToNewBOSSExpression(9015000)}); // NOLINT
+  auto* s = symbolNameToNewBOSSSymbol("UnevaluatedAsNoEngineIsSet");
+  auto* c = newComplexBOSSExpression(s, 1, input.data());
+  auto* res = BOSSEvaluate(c);
+  auto* result = getArgumentsFromBOSSExpression(res);
+  auto const typeID = getBOSSExpressionTypeID(result[0]);
+  auto const unscaledValue = getDecimalValueFromBOSSExpression(result[0]);
+  freeBOSSSymbol(s);
+  freeBOSSExpression(res);
+  freeBOSSExpression(input[0]);
+  freeBOSSArguments(result);
+  CHECK(typeID == 9);
+  CHECK(unscaledValue == 9015000); // NOLINT
+}
+
 TEST_CASE("Build expression, with strings", "[api]") {
   auto input = (std::array{stringToNewBOSSExpression("test string")});
   auto* s = symbolNameToNewBOSSSymbol("UnevaluatedAsNoEngineIsSet");